@@ -26,6 +26,7 @@
 #include "ns3/wifi-module.h"
 #include "ns3/netanim-module.h"
 #include <iostream>
+#include <fstream>
 #include <cmath>
 
 using namespace ns3;
@@ -42,18 +43,18 @@ class DVHopExample
 public:
   /// Default constructor 
   DVHopExample ();
-  /// NonDefault Constructor with time of simulation passed
-  DVHopExample (double time);
   /// Configure script parameters, \return true on successful configuration
   bool Configure (int argc, char **argv);
-  /// Run simulation, boolean to determine ideal/critical scenario
-  void Run (bool crit);
-  /// Report results
+  /// Run simulation
+  void Run ();
+  /// Prints the final results
   void Report () const;
   /// Sets the simulation time (primary use in critical condition but does not effect ideal)
   void SetSimTime ();
   /// Prints a nodes coordinate information to an output file
   void PrintNodes ();
+  /// Dumps the distance and routing tables of every node as they are when the run ends
+  void PrintTables () const;
 
 
 private:
@@ -69,8 +70,41 @@ private:
   bool printRoutes;
   // Percentage of beacon nodes
   uint32_t beaconPercentage;
+  /// Critical conditions: regular nodes may die during the simulation
+  bool critical;
+  /// HELLO interval, seconds
+  double helloInterval;
+  /// Radio range, meters
+  double range;
+  /// Link layer: "wifi" (802.11a ad hoc) or "unitdisk" (UnitDiskChannel, no PHY/MAC)
+  std::string channel;
+  /// Packet loss probability of the unit disk channel
+  double lossProbability;
+  /// Side of the square field, meters
+  double fieldSize;
+  /// Time between two reports, seconds
+  double reportInterval;
+  /// Output files, an empty name disables the file
+  std::string nodesFile;
+  std::string distancesFile;
+  std::string routesFile;
+  std::string reportFile;
+  std::string detailFile;
+  std::string countersFile;
+  std::string animFile;
+  /// Start from the converged distance tables instead of flooding first
+  bool warmStart;
+  /// Stop the simulation once every table and estimate is stable
+  bool stopOnConvergence;
+  /// Number of stable HELLO intervals that make the network converged
+  uint32_t stableIntervals;
   //\}
 
+  /// Convergence detection, only with stopOnConvergence
+  Ptr<DVHopConvergenceMonitor> monitor;
+  /// Report rows: time, alive nodes, nodes with a position, localization error statistics
+  Ptr<DVHopStatistics> statistics;
+
   ///\name network
   //\{
   NodeContainer nodes;
@@ -92,38 +126,19 @@ private:
 const u_int32_t SIZE = 100;               // Number of nodes
 const u_int32_t DEFAULT_TIME = 10;      // Default simulation time
 const u_int32_t DEFAULT_SEED = 12345;   // Default simulation seed
-const double SENT = -1.0;               // Sentinel Value
 const u_int32_t DEFAULT_BEACON_PERCENTAGE = 25;      // Default percentage of beacons 25%
 const u_int32_t DEFAULT_REPORT_INTERVAL = 1;      // Report interval
+const double DEFAULT_RANGE = 25.0;      // Radio range, m
+const double DEFAULT_FIELD_SIZE = 100.0; // Field side, m
 
 int main (int argc, char **argv)                          // Main loop invitation 
 {
-  char ansA;
-  bool crit = false;
-  double time = 0.0;
-
-  // User determination of whether the simulation is critical or ideal
-  std::cout << "\nShould this be a critical simulation? (Y or N)\n";
-  std::cin.get(ansA);
-  ansA = toupper(ansA);
-
-  if(ansA == 'Y')
-    crit = true;
-
-  // User determination of simulation time
-  std::cout << "\nPlease input simulation time-span in seconds. For default time ("<< DEFAULT_TIME <<"s) input -1\n";
-  std::cin >> time;
-
   DVHopExample test;                                      // Creates DVHop 
-  // Sets new simulation time if requested other than default (input not SENT)
-  if(time != SENT)
-    test = DVHopExample(abs(time)); // Ensures a non negative simulation time
-
 
   if (!test.Configure (argc, argv))                       // Triggers in the event test objects configuration fails
     NS_FATAL_ERROR ("Configuration failed. Aborted.");    // Declares error if the trigger condition is met.
 
-  test.Run (crit);                                   // Initiates running sequence of DVhop simulation
+  test.Run ();                                            // Initiates running sequence of DVhop simulation
 
   Simulator::Destroy ();                                  // Recycles simulation resources post execution
   return 0;                                               // Return successful execution 
@@ -135,16 +150,24 @@ DVHopExample::DVHopExample () :
   totalTime (DEFAULT_TIME),         // Sets simulation run time
   pcap (false),            // Enables pcap generation
   printRoutes (true),      // Enables route printing
-  beaconPercentage (DEFAULT_BEACON_PERCENTAGE)      // Set the default beacon percentage to 25
-{
-}
-
-DVHopExample::DVHopExample (double time) :
-  size (SIZE),              			// Sets number of nodes
-  totalTime (time),         // Sets simulation run time
-  pcap (false),            // Enables pcap generation
-  printRoutes (true),      // Enables route printing
-  beaconPercentage (DEFAULT_BEACON_PERCENTAGE)      // Set the default beacon percentage to 25
+  beaconPercentage (DEFAULT_BEACON_PERCENTAGE),      // Set the default beacon percentage to 25
+  critical (false),        // Ideal conditions
+  helloInterval (1.0),
+  range (DEFAULT_RANGE),
+  channel ("wifi"),
+  lossProbability (0.0),
+  fieldSize (DEFAULT_FIELD_SIZE),
+  reportInterval (DEFAULT_REPORT_INTERVAL),
+  nodesFile ("nodes.csv"),
+  distancesFile ("dvhop.distances"),
+  routesFile ("dvhop.routes"),
+  reportFile ("dvhop_report.csv"),
+  detailFile (""),
+  countersFile (""),
+  animFile ("anim_ideal.xml"),
+  warmStart (false),          // Flood from empty tables
+  stopOnConvergence (false),  // Run for the whole simulation time
+  stableIntervals (3)
 {
 }
 
@@ -158,19 +181,68 @@ DVHopExample::Configure (int argc, char **argv)
   SeedManager::SetSeed (DEFAULT_SEED);
   
   CommandLine cmd;
+  std::string scenario;
 
+  cmd.AddValue ("scenario", "File of key=value lines with any of these options, overridden by the command line.", scenario);
   cmd.AddValue ("pcap", "Write PCAP traces.", pcap);
   cmd.AddValue ("printRoutes", "Print routing table dumps.", printRoutes);
   cmd.AddValue ("size", "Number of nodes.", size);
   cmd.AddValue ("time", "Simulation time, s.", totalTime);
   cmd.AddValue ("beaconPercentage", "Percentage of beacons.", beaconPercentage);
+  cmd.AddValue ("critical", "Critical conditions, regular nodes may die.", critical);
+  cmd.AddValue ("helloInterval", "HELLO interval, s.", helloInterval);
+  cmd.AddValue ("range", "Radio range, m.", range);
+  cmd.AddValue ("channel", "Link layer: wifi or unitdisk (direct delivery within range, much faster).", channel);
+  cmd.AddValue ("lossProbability", "Packet loss probability with the unitdisk channel.", lossProbability);
+  cmd.AddValue ("fieldSize", "Side of the square field, m.", fieldSize);
+  cmd.AddValue ("reportInterval", "Time between two reports, s.", reportInterval);
+  cmd.AddValue ("nodesFile", "Node positions CSV, empty to disable.", nodesFile);
+  cmd.AddValue ("distancesFile", "Distance table dump, empty to disable.", distancesFile);
+  cmd.AddValue ("routesFile", "Routing table dump, empty to disable.", routesFile);
+  cmd.AddValue ("reportFile", "Report CSV (time, alive, fixes, average, median, 90th and 95th percentile LE), empty to disable.", reportFile);
+  cmd.AddValue ("detailFile", "Per node CSV every report interval (time, node, alive, x, y, LE), empty to disable.", detailFile);
+  cmd.AddValue ("countersFile", "Per node protocol counters CSV at the end of the run, empty to disable.", countersFile);
+  cmd.AddValue ("animFile", "NetAnim trace, empty to disable.", animFile);
+  cmd.AddValue ("warmStart", "Start with converged distance tables computed from the positions and range.", warmStart);
+  cmd.AddValue ("stopOnConvergence", "Stop once the network is stable.", stopOnConvergence);
+  cmd.AddValue ("stableIntervals", "HELLO intervals without change before the network is considered stable.", stableIntervals);
+
+  // The scenario file comes first so the command line overrides it
+  std::vector<std::string> args (argv, argv + argc);
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg.compare (0, 11, "--scenario=") == 0)
+        scenario = arg.substr (11);
+    }
+  if (!scenario.empty ())
+    {
+      std::ifstream file (scenario.c_str ());
+      if (!file)
+        {
+          std::cerr << "Cannot open scenario file " << scenario << std::endl;
+          return false;
+        }
+      std::vector<std::string> options;
+      std::string line;
+      while (std::getline (file, line))
+        {
+          line = line.substr (0, line.find ('#'));        // Comments
+          line.erase (0, line.find_first_not_of (" \t"));
+          line.erase (line.find_last_not_of (" \t\r") + 1);
+          if (!line.empty ())
+            options.push_back ("--" + line);
+        }
+      args.insert (args.begin () + 1, options.begin (), options.end ());
+    }
 
-  cmd.Parse (argc, argv);
-  return true;
+  cmd.Parse (args);
+  return totalTime > 0 && helloInterval > 0 && reportInterval > 0 && fieldSize > 0
+         && (channel == "wifi" || channel == "unitdisk");
 }
 
 void
-DVHopExample::Run (bool crit)
+DVHopExample::Run ()
 {
 //  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", UintegerValue (1)); // enable rts cts all the time.
   CreateNodes ();                  // Creates nodes for simulation
@@ -178,85 +250,101 @@ DVHopExample::Run (bool crit)
   InstallInternetStack ();         // Establishes Internet topology
 
   // If user indicates for a crititcal simulation, set protocols
-  if(crit)
+  if(critical)
     MakeCritical();
 
   CreateBeacons();                  // Converts a number of nodes to beacons
   SetSimTime();
 
+  if (warmStart)
+    {
+      // Skip the flooding phase, both channels have unit disk links of this range
+      DVHopHelper dvhop;
+      dvhop.WarmStart (nodes, range);
+    }
+
   std::cout << "Starting simulation for " << totalTime << " s ...\n";
 
   Simulator::Stop (Seconds (totalTime));      // Establishes the Stop time for the simulation
 
+  if (stopOnConvergence)
+    {
+      monitor = CreateObject<DVHopConvergenceMonitor> ();
+      monitor->SetAttribute ("StableIntervals", UintegerValue (stableIntervals));
+      monitor->SetAttribute ("CheckInterval", TimeValue (Seconds (helloInterval)));
+      monitor->Install (nodes);
+    }
+
 
-  Simulator::Schedule(Seconds(DEFAULT_REPORT_INTERVAL), &DVHopExample::Report, this);
-  AnimationInterface anim("anim_ideal.xml");   // Establishes the file for animation generation of simulation    
+  statistics = CreateObject<DVHopStatistics> ();
+  statistics->SetAttribute ("ReportInterval", TimeValue (Seconds (reportInterval)));
+  statistics->SetAttribute ("ReportFile", StringValue (reportFile));
+  statistics->SetAttribute ("DetailFile", StringValue (detailFile));
+  statistics->Install (nodes);
+  AnimationInterface *anim = 0;
+  if (!animFile.empty ())
+    anim = new AnimationInterface (animFile);   // Establishes the file for animation generation of simulation    
 
   Simulator::Run ();        // Runs the sim
+  delete anim;
+  // Not scheduled at totalTime: the convergence monitor may stop the run earlier
+  PrintTables ();
 
+  if (monitor)
+    {
+      if (monitor->IsConverged ())
+        std::cout << "Converged at " << monitor->GetConvergenceTime ().GetSeconds () << " s, stopped at "
+                  << Simulator::Now ().GetSeconds () << " s" << std::endl;
+      else
+        std::cout << "Not converged after " << totalTime << " s" << std::endl;
+      std::cout << "Nodes with a position fix: " << monitor->GetNodesWithFix () << "/" << size << std::endl;
+    }
+  Report ();
+  statistics->Dispose ();   // Closes the report files
 }
 
 void
 DVHopExample::Report () const
 {
-  std::cout<< "Report at Time: " << Simulator::Now()<< std::endl;
-  // Go through all non anchor nodes and calculate the localization error
-  double totalLE = 0;
-  u_int32_t totalBeacons = 0;
-  u_int32_t totalTrilateration = 0;
-  u_int32_t totalNodesAlive = 0;
-
-  for(uint32_t i=0; i < size; i++) {
-    Ptr <Ipv4RoutingProtocol> proto = nodes.Get(i)->GetObject<Ipv4>()->GetRoutingProtocol();
-    Ptr <dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol>(proto);
-
-    if(dvhop->IsAlive()) {
-      totalNodesAlive += 1;
-    }
-    if(dvhop->IsBeacon()) {
-      totalBeacons += 1;
-      continue; // Dont calculate beacon error
-    }
-
-    if(dvhop->GetXPosition() == -1 && dvhop->GetYPosition() == -1) { //position not calculated by trilateration
-      continue;
+  // Totals at the end of the run, the periodic rows come from the statistics collector
+  DVHopHelper helper;
+  dvhop::ProtocolCounters counters = helper.SumCounters (nodes);
+
+  std::cout << "Report at Time: " << Simulator::Now () << "\n"
+            << "Average Localization Error LE of " << statistics->GetNodesWithFix () << "/"
+            << statistics->GetRegularNodes () << " = " << statistics->GetAverageError () << "\n"
+            << "Median / 90th percentile LE = " << statistics->GetErrorPercentile (0.5) << " / "
+            << statistics->GetErrorPercentile (0.9) << "\n"
+            << "Nodes Alive: " << statistics->GetAlive () << "/" << size << "\n"
+            << "HELLOs sent: " << counters.hellosSent << " (" << counters.helloBytesSent << " bytes), received: "
+            << counters.packetsReceived << ", lost: " << counters.hellosLost << "\n"
+            << "Solver runs: " << counters.solverRuns << ", failures: " << counters.solverFailures << std::endl;
+  if (!countersFile.empty ())
+    {
+      std::ofstream file (countersFile.c_str ());
+      helper.PrintCounters (nodes, file);
     }
-    totalTrilateration += 1;
-
-    Ptr <MobilityModel> mob = nodes.Get(i)->GetObject<MobilityModel>();
-
-    double dx = dvhop->GetXPosition() - mob->GetPosition().x;
-    double dy = dvhop->GetYPosition() - mob->GetPosition().y;
-    double LE = pow(pow(dx,2) + pow(dy,2), 0.5);
-
-    std::cout << "Localization Error LE for Node " << i << " = " << LE << std::endl;
-
-    totalLE += LE;
-  }
-  double averageLE = totalLE / totalTrilateration;
-  std::cout << "Average Localization Error LE of " << totalTrilateration << "/" << (size-totalBeacons) << " = "<<averageLE << std::endl;
-  std::cout << "Nodes Alive: " << totalNodesAlive << "/" << size << std::endl;
-  Simulator::Schedule(Seconds(DEFAULT_REPORT_INTERVAL), &DVHopExample::Report, this);
 }
 
 void
 DVHopExample::CreateNodes ()
 {
-  std::cout << "Creating RandomRectangle Nodes" << (unsigned)size << " nodes within 100m by 100m\n";
+  std::cout << "Creating RandomRectangle Nodes" << (unsigned)size << " nodes within " << fieldSize << "m by " << fieldSize << "m\n";
   nodes.Create (size);	// Create all nodes + beacons
   // Name nodes
   for (uint32_t i = 0; i < size; ++i)
     {
       std::ostringstream os;
       os << "node-" << i;
-      std::cout << "Creating node: "<< os.str ()<< std::endl ;
       Names::Add (os.str (), nodes.Get (i));
     }
   // Create static grid
   MobilityHelper mobility;
+  std::ostringstream bounds;
+  bounds << "ns3::UniformRandomVariable[Min=0|Max=" << fieldSize << "]";
   mobility.SetPositionAllocator ("ns3::RandomRectanglePositionAllocator",
-                                 "X", StringValue ("ns3::UniformRandomVariable[Min=0|Max=100]"),
-                                 "Y", StringValue ("ns3::UniformRandomVariable[Min=0|Max=100]"));
+                                 "X", StringValue (bounds.str ()),
+                                 "Y", StringValue (bounds.str ()));
   mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
   mobility.Install (nodes);
 }
@@ -298,7 +386,9 @@ DVHopExample::CreateBeacons ()
 void
 DVHopExample::PrintNodes ()
 {
-  Ptr<OutputStreamWrapper> distStream = Create<OutputStreamWrapper>("nodes.csv", std::ios::out);
+  if (nodesFile.empty ())
+    return;
+  Ptr<OutputStreamWrapper> distStream = Create<OutputStreamWrapper>(nodesFile, std::ios::out);
   for(uint32_t i = 0; i < size; ++i)
   {
     Ptr<Ipv4RoutingProtocol> proto = nodes.Get (i)->GetObject<Ipv4>()->GetRoutingProtocol ();
@@ -317,12 +407,23 @@ DVHopExample::PrintNodes ()
 void
 DVHopExample::CreateDevices ()
 {
+  if (channel == "unitdisk")
+    {
+      // Same unit disk links as the Wi-Fi setup below, without simulating the PHY and MAC
+      Ptr<dvhop::UnitDiskChannel> unitDisk = CreateObject<dvhop::UnitDiskChannel> ();
+      unitDisk->SetAttribute ("Range", DoubleValue (range));
+      unitDisk->SetAttribute ("LossProbability", DoubleValue (lossProbability));
+      SimpleNetDeviceHelper simple;
+      devices = simple.Install (nodes, unitDisk);
+      return;
+    }
+
   WifiMacHelper wifiMac = WifiMacHelper();
   wifiMac.SetType ("ns3::AdhocWifiMac");
   YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
   YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
   wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
-  wifiChannel.AddPropagationLoss("ns3::RangePropagationLossModel","MaxRange", DoubleValue (25.0));
+  wifiChannel.AddPropagationLoss("ns3::RangePropagationLossModel","MaxRange", DoubleValue (range));
   wifiPhy.SetChannel (wifiChannel.Create ());
   WifiHelper wifi = WifiHelper();
   wifi.SetStandard(WIFI_PHY_STANDARD_80211a);
@@ -341,20 +442,47 @@ DVHopExample::InstallInternetStack ()
 {
   DVHopHelper dvhop;
   // you can configure DVhop attributes here using aodv.Set(name, value)
+  dvhop.Set ("HelloInterval", TimeValue (Seconds (helloInterval)));
+  dvhop.Set ("FieldWidth", DoubleValue (fieldSize));
+  dvhop.Set ("FieldHeight", DoubleValue (fieldSize));
   InternetStackHelper stack;
   stack.SetRoutingHelper (dvhop); // has effect on the next Install ()
   stack.Install (nodes);
   Ipv4AddressHelper address;
   address.SetBase ("10.0.0.0", "255.0.0.0");                                                            // Adjust the IP address to the following 
   interfaces = address.Assign (devices);
+}
 
-  Ptr<OutputStreamWrapper> distStream = Create<OutputStreamWrapper>("dvhop.distances", std::ios::out);
-  dvhop.PrintDistanceTableAllAt(Seconds(totalTime), distStream);
+void
+DVHopExample::PrintTables () const
+{
+  Ptr<OutputStreamWrapper> distStream;
+  Ptr<OutputStreamWrapper> routingStream;
+  if (!distancesFile.empty ())
+    {
+      distStream = Create<OutputStreamWrapper> (distancesFile, std::ios::out);
+    }
+  if (printRoutes && !routesFile.empty ())
+    {
+      routingStream = Create<OutputStreamWrapper> (routesFile, std::ios::out);
+    }
 
-  if (printRoutes)
+  for (uint32_t i = 0; i < size; ++i)
     {
-      Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ("dvhop.routes", std::ios::out);
-      dvhop.PrintRoutingTableAllAt (Seconds (totalTime), routingStream);
+      Ptr<Node> node = nodes.Get (i);
+      Ptr<Ipv4RoutingProtocol> proto = node->GetObject<Ipv4> ()->GetRoutingProtocol ();
+      Ptr<dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol> (proto);
+      if (distStream)
+        {
+          dvhop->PrintDistances (distStream, node);
+        }
+      if (routingStream)
+        {
+          *routingStream->GetStream () << "Node: " << node->GetId ()
+                                       << ", Time: " << Simulator::Now ().GetSeconds () << "s\n";
+          proto->PrintRoutingTable (routingStream);
+          *routingStream->GetStream () << "\n";
+        }
     }
 }
 
@@ -0,0 +1,355 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+    Microbenchmarks of the DV-Hop kernels, without a simulation.
+
+    Every kernel runs in a calibrated loop of at least --minTime seconds,
+    --repeats times. The inputs come from a fixed seed, so two builds time
+    the same work. One CSV row per kernel and size is written to --output
+    (stdout by default):
+      benchmark,size,repeats,ops,ns_per_op_median,ns_per_op_min,ops_per_s
+    ops is the number of operations of one repeat and ops_per_s is derived
+    from the median. Compare the median between commits; the minimum shows
+    how noisy the machine was.
+
+    Kernels, size being the number of table entries or beacons:
+      table_add               DistanceTable::AddBeacon of new beacons, per entry
+      table_update            DistanceTable::AddBeacon of known beacons, per entry
+      table_find              DistanceTable::Find in random order, per lookup
+      table_iterate           Begin/End pass over the table, per entry
+      table_known_beacons     GetKnownBeacons, per entry
+      header_roundtrip        FloodingHeader Serialize + Deserialize (size 1)
+      batch_roundtrip_full    FloodingBatchHeader round trip, full format, per entry
+      batch_roundtrip_compact FloodingBatchHeader round trip, compact format, per entry
+      trilaterate             Trilaterate from three beacons (size 3), per solve
+      least_squares_add       LeastSquaresSolver::Add, per beacon
+      least_squares_solve     LeastSquaresSolver::Solve with size beacons, per solve
+
+    ./waf --run "dvhop-microbenchmark --sizes=10,100,1000,10000 --output=micro.csv"
+*/
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/dvhop-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+  struct BenchmarkConfig
+  {
+    double   minTime;
+    uint32_t repeats;
+  };
+
+  // Keeps the results alive so the loops are not optimized away
+  volatile double g_sink = 0;
+
+  // Deterministic inputs, independent of the ns-3 RNG settings
+  class Lcg
+  {
+  public:
+    explicit Lcg (uint64_t seed) : m_state (seed) {}
+    uint32_t Next ()
+    {
+      m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+      return m_state >> 33;
+    }
+    double Uniform (double max) { return max * Next () / 2147483648.0; }
+
+  private:
+    uint64_t m_state;
+  };
+
+  double
+  ElapsedNs (std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+  }
+
+  /**
+   * Times a kernel: run (rounds) performs rounds rounds of opsPerRound
+   * operations. The round count is doubled until one repeat lasts minTime.
+   */
+  template <typename Kernel>
+  void
+  Measure (std::ostream &os, const BenchmarkConfig &config, const char *name, uint32_t size,
+           uint64_t opsPerRound, Kernel run)
+  {
+    uint64_t rounds = 1;
+    run (1); // Warm up caches and allocations
+    while (true)
+      {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+        run (rounds);
+        if (ElapsedNs (start) >= config.minTime * 1e9 || rounds >= (1ULL << 40))
+          break;
+        rounds *= 2;
+      }
+
+    std::vector<double> nsPerOp;
+    for (uint32_t r = 0; r < config.repeats; ++r)
+      {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+        run (rounds);
+        nsPerOp.push_back (ElapsedNs (start) / (rounds * opsPerRound));
+      }
+    std::sort (nsPerOp.begin (), nsPerOp.end ());
+    double median = nsPerOp[nsPerOp.size () / 2];
+    os << name << "," << size << "," << config.repeats << "," << rounds * opsPerRound << ","
+       << median << "," << nsPerOp.front () << "," << (median > 0 ? 1e9 / median : 0) << std::endl;
+  }
+
+  // Beacons 10.0.x.x in random order, random positions on a 1 km field
+  void
+  MakeBeacons (uint32_t size, std::vector<Ipv4Address> &addresses, std::vector<double> &x, std::vector<double> &y)
+  {
+    Lcg rng (size);
+    addresses.resize (size);
+    x.resize (size);
+    y.resize (size);
+    for (uint32_t i = 0; i < size; ++i)
+      {
+        addresses[i] = Ipv4Address (0x0a000001 + i);
+        x[i] = rng.Uniform (1000);
+        y[i] = rng.Uniform (1000);
+      }
+    for (uint32_t i = size; i > 1; --i)
+      {
+        std::swap (addresses[i - 1], addresses[rng.Next () % i]);
+      }
+  }
+
+  void
+  BenchmarkTable (std::ostream &os, const BenchmarkConfig &config, uint32_t size)
+  {
+    std::vector<Ipv4Address> addresses;
+    std::vector<double> x, y;
+    MakeBeacons (size, addresses, x, y);
+
+    Measure (os, config, "table_add", size, size, [&] (uint64_t rounds) {
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          dvhop::DistanceTable table;
+          for (uint32_t i = 0; i < size; ++i)
+            table.AddBeacon (addresses[i], 1 + i % 20, 12.5, x[i], y[i]);
+          g_sink = g_sink + table.GetSize ();
+        }
+    });
+
+    dvhop::DistanceTable table;
+    for (uint32_t i = 0; i < size; ++i)
+      table.AddBeacon (addresses[i], 1 + i % 20, 12.5, x[i], y[i]);
+
+    Measure (os, config, "table_update", size, size, [&] (uint64_t rounds) {
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          for (uint32_t i = 0; i < size; ++i)
+            table.AddBeacon (addresses[i], 1 + (i + r) % 20, 12.5, x[i], y[i]);
+        }
+      g_sink = g_sink + table.GetHopsTo (addresses[0]);
+    });
+
+    // Lookups in an order unrelated to the insertion order
+    std::vector<Ipv4Address> queries (addresses);
+    Lcg rng (size + 1);
+    for (uint32_t i = size; i > 1; --i)
+      std::swap (queries[i - 1], queries[rng.Next () % i]);
+    Measure (os, config, "table_find", size, size, [&] (uint64_t rounds) {
+      uint64_t hops = 0;
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          for (uint32_t i = 0; i < size; ++i)
+            hops += table.Find (queries[i])->GetHops ();
+        }
+      g_sink = g_sink + hops;
+    });
+
+    Measure (os, config, "table_iterate", size, size, [&] (uint64_t rounds) {
+      double sum = 0;
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          for (dvhop::DistanceTable::Iterator it = table.Begin (); it != table.End (); ++it)
+            sum += it->GetHops () * it->GetHopSize ();
+        }
+      g_sink = g_sink + sum;
+    });
+
+    Measure (os, config, "table_known_beacons", size, size, [&] (uint64_t rounds) {
+      uint64_t sum = 0;
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          std::vector<Ipv4Address> known = table.GetKnownBeacons ();
+          sum += known.size () + known.back ().Get ();
+        }
+      g_sink = g_sink + sum;
+    });
+  }
+
+  void
+  BenchmarkBatch (std::ostream &os, const BenchmarkConfig &config, uint32_t size, bool compact)
+  {
+    std::vector<Ipv4Address> addresses;
+    std::vector<double> x, y;
+    MakeBeacons (size, addresses, x, y);
+
+    dvhop::FloodingBatchHeader batch;
+    if (compact)
+      batch.SetCompact (24, 0.01);
+    for (uint32_t i = 0; i < size; ++i)
+      batch.AddEntry (dvhop::FloodingHeader (x[i], y[i], i, 1 + i % 20, 12.5, addresses[i]));
+
+    Buffer buffer;
+    buffer.AddAtStart (batch.GetSerializedSize ());
+    dvhop::FloodingBatchHeader received;
+    Measure (os, config, compact ? "batch_roundtrip_compact" : "batch_roundtrip_full", size, size,
+             [&] (uint64_t rounds) {
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          batch.Serialize (buffer.Begin ());
+          received.Deserialize (buffer.Begin ());
+        }
+      g_sink = g_sink + received.GetEntry (size - 1).GetHopCount ();
+    });
+  }
+
+  void
+  BenchmarkHeader (std::ostream &os, const BenchmarkConfig &config)
+  {
+    dvhop::FloodingHeader header (123.25, 456.5, 7, 3, 12.5, Ipv4Address ("10.0.0.1"));
+    dvhop::FloodingHeader received;
+    Buffer buffer;
+    buffer.AddAtStart (header.GetSerializedSize ());
+    Measure (os, config, "header_roundtrip", 1, 1, [&] (uint64_t rounds) {
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          header.Serialize (buffer.Begin ());
+          received.Deserialize (buffer.Begin ());
+        }
+      g_sink = g_sink + received.GetXPosition ();
+    });
+  }
+
+  void
+  BenchmarkSolvers (std::ostream &os, const BenchmarkConfig &config, const std::vector<uint32_t> &sizes)
+  {
+    // A node at (400, 300) and noisy hop-count distances, as after flooding
+    const uint32_t problems = 1024;
+    std::vector<double> bx (3 * problems), by (3 * problems), bd (3 * problems);
+    Lcg rng (3);
+    for (uint32_t i = 0; i < 3 * problems; ++i)
+      {
+        bx[i] = rng.Uniform (1000);
+        by[i] = rng.Uniform (1000);
+        double dx = bx[i] - 400, dy = by[i] - 300;
+        bd[i] = std::sqrt (dx * dx + dy * dy) * (0.8 + rng.Uniform (0.4));
+      }
+    Measure (os, config, "trilaterate", 3, problems, [&] (uint64_t rounds) {
+      double sum = 0, xOut, yOut;
+      for (uint64_t r = 0; r < rounds; ++r)
+        {
+          for (uint32_t p = 0; p < problems; ++p)
+            {
+              if (dvhop::Trilaterate (&bx[3 * p], &by[3 * p], &bd[3 * p], xOut, yOut))
+                sum += xOut + yOut;
+            }
+        }
+      g_sink = g_sink + sum;
+    });
+
+    for (uint32_t s = 0; s < sizes.size (); ++s)
+      {
+        uint32_t size = std::max<uint32_t> (sizes[s], 3);
+        std::vector<double> x, y, d;
+        std::vector<Ipv4Address> unused;
+        MakeBeacons (size, unused, x, y);
+        for (uint32_t i = 0; i < size; ++i)
+          {
+            double dx = x[i] - 400, dy = y[i] - 300;
+            d.push_back (std::sqrt (dx * dx + dy * dy) * (0.8 + rng.Uniform (0.4)));
+          }
+
+        Measure (os, config, "least_squares_add", size, size, [&] (uint64_t rounds) {
+          dvhop::LeastSquaresSolver solver;
+          for (uint64_t r = 0; r < rounds; ++r)
+            {
+              for (uint32_t i = 0; i < size; ++i)
+                solver.Add (x[i], y[i], d[i]);
+            }
+          g_sink = g_sink + solver.GetN ();
+        });
+
+        dvhop::LeastSquaresSolver solver;
+        for (uint32_t i = 0; i < size; ++i)
+          solver.Add (x[i], y[i], d[i]);
+        Measure (os, config, "least_squares_solve", size, 1, [&] (uint64_t rounds) {
+          double sum = 0, xOut, yOut;
+          for (uint64_t r = 0; r < rounds; ++r)
+            {
+              if (solver.Solve (xOut, yOut))
+                sum += xOut;
+            }
+          g_sink = g_sink + sum;
+        });
+      }
+  }
+
+}
+
+int
+main (int argc, char **argv)
+{
+  std::string sizes = "10,100,1000,10000";
+  std::string output;
+  BenchmarkConfig config;
+  config.minTime = 0.1;
+  config.repeats = 5;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "Comma separated table and batch sizes.", sizes);
+  cmd.AddValue ("minTime", "Minimum duration of one repeat, s.", config.minTime);
+  cmd.AddValue ("repeats", "Timed repeats per kernel, the median is reported.", config.repeats);
+  cmd.AddValue ("output", "CSV file, stdout if empty.", output);
+  cmd.Parse (argc, argv);
+  if (config.repeats == 0)
+    NS_FATAL_ERROR ("--repeats must be at least 1");
+
+  std::vector<uint32_t> sizeList;
+  std::istringstream list (sizes);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      uint32_t size = std::strtoul (item.c_str (), 0, 10);
+      if (size > 0)
+        sizeList.push_back (std::min<uint32_t> (size, 65535)); // Batch entry count is 16 bits
+    }
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file)
+        NS_FATAL_ERROR ("Cannot open " << output);
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+  os << "benchmark,size,repeats,ops,ns_per_op_median,ns_per_op_min,ops_per_s" << std::endl;
+
+  for (uint32_t s = 0; s < sizeList.size (); ++s)
+    BenchmarkTable (os, config, sizeList[s]);
+  BenchmarkHeader (os, config);
+  for (uint32_t s = 0; s < sizeList.size (); ++s)
+    {
+      BenchmarkBatch (os, config, sizeList[s], false);
+      BenchmarkBatch (os, config, sizeList[s], true);
+    }
+  BenchmarkSolvers (os, config, sizeList);
+  return 0;
+}
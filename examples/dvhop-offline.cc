@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+    Offline DV-Hop evaluator.
+
+    Computes the converged DV-Hop result of a layout without simulating
+    packets: it reads a node file in the format dvhop-example writes
+    (x,y,isBeacon per line), links the nodes within range with a spatial
+    grid (dvhop::UnitDiskGraph) and runs one BFS per beacon on all threads.
+    Each BFS gives the beacon's hop size as in RecalculateHopSize (distance to
+    every reachable beacon over the hops to it), then the beacon's estimated
+    distance to every node. Nodes are then localized with the same
+    estimators as RoutingProtocol::Trilateration:
+      - Trilateration: the three beacons with a known hop size and the
+        lowest addresses. dvhop-example assigns addresses in node order,
+        so these are the first three in the file.
+      - LeastSquares: every reachable beacon with a known hop size.
+    The floods run in rounds of one beacon per thread: the workers start
+    once and take beacons from a shared counter. After each round every
+    worker adds the round's beacons to its own slice of the nodes, so the
+    per node state exists once whatever the thread count.
+
+    The report has the layout of dvhop_report.csv (time, nodes, nodes with
+    a position, average localization error), with a single row.
+
+    ./waf --run "dvhop-offline --nodes=nodes.csv --range=25 --threads=8"
+*/
+
+#include "ns3/core-module.h"
+#include "ns3/dvhop-module.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+  // A beacon reached by a node, ordered by address
+  struct Candidate
+  {
+    uint32_t line;     // Line of the beacon in the node file
+    uint16_t hops;
+    uint32_t beacon;   // Index in the beacon list
+
+    bool operator< (const Candidate &o) const
+    {
+      return line < o.line;
+    }
+  };
+
+  // The three usable beacons of a node with the lowest addresses
+  struct Nearest
+  {
+    Candidate c[3];
+    uint8_t   n;
+
+    Nearest () : n (0) {}
+
+    void Add (const Candidate &cand)
+    {
+      if (n == 3 && !(cand < c[2]))
+        return;
+      int i = n < 3 ? n++ : 2;
+      while (i > 0 && cand < c[i - 1])
+        {
+          c[i] = c[i - 1];
+          --i;
+        }
+      c[i] = cand;
+    }
+  };
+
+  // Result of one beacon flood
+  struct Flood
+  {
+    uint32_t beacon;               // Index in the beacon list
+    double   hopSize;              // Negative if the beacon reaches no other beacon
+    std::vector<uint16_t> hops;    // Per node
+  };
+
+  // Blocks the threads until all of them reach it, reusable across rounds
+  class Barrier
+  {
+  public:
+    explicit Barrier (uint32_t count) : m_count (count), m_waiting (0), m_generation (0) {}
+
+    void Wait ()
+    {
+      std::unique_lock<std::mutex> lock (m_mutex);
+      uint32_t generation = m_generation;
+      if (++m_waiting == m_count)
+        {
+          m_waiting = 0;
+          ++m_generation;
+          m_released.notify_all ();
+          return;
+        }
+      m_released.wait (lock, [&] () { return generation != m_generation; });
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    uint32_t m_count;
+    uint32_t m_waiting;
+    uint32_t m_generation;
+  };
+
+  bool
+  ReadNodes (const std::string &path, std::vector<double> &x, std::vector<double> &y, std::vector<bool> &beacon)
+  {
+    std::ifstream file (path.c_str ());
+    if (!file)
+      return false;
+    std::string line;
+    while (std::getline (file, line))
+      {
+        const char *p = line.c_str ();
+        char *end;
+        double px = std::strtod (p, &end);
+        if (end == p || *end != ',')
+          continue;   // Header or blank line
+        p = end + 1;
+        double py = std::strtod (p, &end);
+        if (end == p || *end != ',')
+          continue;
+        p = end + 1;
+        long isBeacon = std::strtol (p, &end, 10);
+        if (end == p)
+          continue;
+        x.push_back (px);
+        y.push_back (py);
+        beacon.push_back (isBeacon != 0);
+      }
+    return true;
+  }
+
+  // Interleaves the bits of the cell coordinates (Z-order curve)
+  uint64_t
+  Morton (uint32_t cx, uint32_t cy)
+  {
+    uint64_t code = 0;
+    for (int bit = 0; bit < 32; ++bit)
+      {
+        code |= (uint64_t)((cx >> bit) & 1) << (2 * bit);
+        code |= (uint64_t)((cy >> bit) & 1) << (2 * bit + 1);
+      }
+    return code;
+  }
+
+  double
+  ElapsedSeconds (std::chrono::steady_clock::time_point since)
+  {
+    return std::chrono::duration<double> (std::chrono::steady_clock::now () - since).count ();
+  }
+
+}
+
+int
+main (int argc, char **argv)
+{
+  std::string nodesFile = "nodes.csv";
+  std::string reportFile;
+  std::string estimatesFile;
+  std::string solverName = "Trilateration";
+  double range = 25.0;
+  double fieldSize = 100.0;
+  double reportTime = 0;
+  uint32_t threads = std::thread::hardware_concurrency ();
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Node file, x,y,isBeacon per line.", nodesFile);
+  cmd.AddValue ("range", "Radio range, m.", range);
+  cmd.AddValue ("fieldSize", "Side of the field, m. Estimates are clamped to it as in the model.", fieldSize);
+  cmd.AddValue ("solver", "Trilateration or LeastSquares.", solverName);
+  cmd.AddValue ("threads", "Worker threads.", threads);
+  cmd.AddValue ("report", "Report CSV in the dvhop_report.csv layout, stdout if empty.", reportFile);
+  cmd.AddValue ("reportTime", "Value of the time column of the report.", reportTime);
+  cmd.AddValue ("estimates", "Optional per node CSV: id,x,y,isBeacon,estX,estY,error.", estimatesFile);
+  cmd.Parse (argc, argv);
+
+  bool leastSquares = solverName == "LeastSquares";
+  if (!leastSquares && solverName != "Trilateration")
+    NS_FATAL_ERROR ("Unknown solver " << solverName);
+  threads = std::max (threads, 1u);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  std::vector<double> x, y;
+  std::vector<bool> isBeacon;
+  if (!ReadNodes (nodesFile, x, y, isBeacon))
+    NS_FATAL_ERROR ("Cannot read " << nodesFile);
+  uint32_t n = x.size ();
+  if (n == 0)
+    NS_FATAL_ERROR ("No node in " << nodesFile);
+
+  // Renumber the nodes along a Z-order curve of range sized cells, so that
+  // neighbours have close indices and the floods mostly touch memory
+  // sequentially (several times faster than the file order on 1M nodes).
+  // id[i] is the line of node i in the file.
+  std::vector<uint32_t> id (n);
+  {
+    double minX = *std::min_element (x.begin (), x.end ());
+    double minY = *std::min_element (y.begin (), y.end ());
+    std::vector<std::pair<uint64_t, uint32_t> > order (n);
+    for (uint32_t i = 0; i < n; ++i)
+      order[i] = std::make_pair (Morton ((uint32_t)((x[i] - minX) / range), (uint32_t)((y[i] - minY) / range)), i);
+    std::sort (order.begin (), order.end ());
+    std::vector<double> sortedX (n), sortedY (n);
+    std::vector<bool> sortedBeacon (n);
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        id[i] = order[i].second;
+        sortedX[i] = x[id[i]];
+        sortedY[i] = y[id[i]];
+        sortedBeacon[i] = isBeacon[id[i]];
+      }
+    x.swap (sortedX);
+    y.swap (sortedY);
+    isBeacon.swap (sortedBeacon);
+  }
+
+  std::vector<uint32_t> beacons;
+  for (uint32_t i = 0; i < n; ++i)
+    if (isBeacon[i])
+      beacons.push_back (i);
+  std::cerr << n << " nodes, " << beacons.size () << " beacons read in " << ElapsedSeconds (start) << " s" << std::endl;
+
+  start = std::chrono::steady_clock::now ();
+  dvhop::UnitDiskGraph graph;
+  graph.Build (x, y, range);
+  std::cerr << graph.GetNLinks () << " links built in " << ElapsedSeconds (start) << " s" << std::endl;
+
+  // Per node accumulators, shared: each thread only writes its own slice
+  std::vector<Nearest> nearest;
+  std::vector<dvhop::LeastSquaresSolver> solvers;
+  if (leastSquares)
+    solvers.resize (n);
+  else
+    nearest.resize (n);
+
+  // One BFS per beacon, in rounds of one beacon per thread. The workers
+  // live for all the rounds and take the next beacon from a shared counter
+  start = std::chrono::steady_clock::now ();
+  std::vector<double> hopSizes (beacons.size (), -1.0);
+  std::vector<Flood> floods (threads);
+  std::atomic<uint32_t> nextBeacon (0);
+  Barrier barrier (threads);
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < threads; ++t)
+    {
+      workers.push_back (std::thread ([&, t] ()
+        {
+          uint32_t from = (uint64_t) n * t / threads;
+          uint32_t to = (uint64_t) n * (t + 1) / threads;
+          std::vector<uint32_t> order (threads);
+          while (true)
+            {
+              Flood &flood = floods[t];
+              flood.beacon = nextBeacon.fetch_add (1);
+              flood.hopSize = -1.0;
+              if (flood.beacon < beacons.size ())
+                {
+                  uint32_t source = beacons[flood.beacon];
+                  graph.HopCounts (source, flood.hops);
+
+                  // Hop size as in RecalculateHopSize: over every other beacon it knows
+                  double distSum = 0, hopSum = 0;
+                  for (uint32_t k = 0; k < beacons.size (); ++k)
+                    {
+                      uint32_t other = beacons[k];
+                      if (other == source || flood.hops[other] == dvhop::UnitDiskGraph::UNREACHABLE)
+                        continue;
+                      double dx = x[other] - x[source], dy = y[other] - y[source];
+                      distSum += std::sqrt (dx * dx + dy * dy);
+                      hopSum += flood.hops[other];
+                    }
+                  // Nodes ignore beacons without a hop size
+                  flood.hopSize = hopSum > 0 ? distSum / hopSum : -1.0;
+                  hopSizes[flood.beacon] = flood.hopSize;
+                }
+              barrier.Wait ();
+
+              // Add the round's beacons to this thread's slice of the nodes, in
+              // beacon order so that the sums do not depend on the thread count.
+              // A round that ran out of beacons is the last one, for every thread
+              bool last = false;
+              for (uint32_t f = 0; f < threads; ++f)
+                {
+                  order[f] = f;
+                  last = last || floods[f].beacon >= beacons.size ();
+                }
+              std::sort (order.begin (), order.end (), [&] (uint32_t a, uint32_t b)
+                {
+                  return floods[a].beacon < floods[b].beacon;
+                });
+              for (uint32_t f : order)
+                {
+                  const Flood &done = floods[f];
+                  if (done.beacon >= beacons.size () || done.hopSize < 0)
+                    continue;
+                  uint32_t source = beacons[done.beacon];
+                  for (uint32_t i = from; i < to; ++i)
+                    {
+                      if (isBeacon[i] || done.hops[i] == dvhop::UnitDiskGraph::UNREACHABLE)
+                        continue;
+                      if (leastSquares)
+                        {
+                          solvers[i].Add (x[source], y[source], done.hopSize * done.hops[i]);
+                        }
+                      else
+                        {
+                          Candidate cand = { id[source], done.hops[i], done.beacon };
+                          nearest[i].Add (cand);
+                        }
+                    }
+                }
+              // The floods are reused by the next round
+              barrier.Wait ();
+              if (last)
+                break;
+            }
+        }));
+    }
+  for (uint32_t t = 0; t < threads; ++t)
+    workers[t].join ();
+  std::cerr << beacons.size () << " beacon floods in " << ElapsedSeconds (start) << " s" << std::endl;
+
+  // Localize, each thread on a slice of the nodes
+  start = std::chrono::steady_clock::now ();
+  std::vector<double> estX (n, -1.0), estY (n, -1.0);
+  workers.clear ();
+  for (uint32_t t = 0; t < threads; ++t)
+    {
+      workers.push_back (std::thread ([&, t] ()
+        {
+          for (uint32_t i = t; i < n; i += threads)
+            {
+              if (isBeacon[i])
+                continue;
+              double ex, ey;
+              bool solved;
+              if (leastSquares)
+                {
+                  solved = solvers[i].Solve (ex, ey);
+                }
+              else
+                {
+                  solved = false;
+                  if (nearest[i].n == 3)
+                    {
+                      double bx[3], by[3], d[3];
+                      for (int j = 0; j < 3; ++j)
+                        {
+                          uint32_t b = nearest[i].c[j].beacon;
+                          bx[j] = x[beacons[b]];
+                          by[j] = y[beacons[b]];
+                          d[j] = hopSizes[b] * nearest[i].c[j].hops;
+                        }
+                      solved = dvhop::Trilaterate (bx, by, d, ex, ey);
+                    }
+                }
+              if (solved)
+                {
+                  // Bounding the position to the simulation area, as in the model
+                  estX[i] = std::min (std::max (ex, 0.0), fieldSize);
+                  estY[i] = std::min (std::max (ey, 0.0), fieldSize);
+                }
+            }
+        }));
+    }
+  for (uint32_t t = 0; t < threads; ++t)
+    workers[t].join ();
+  std::cerr << "Localized in " << ElapsedSeconds (start) << " s" << std::endl;
+
+  double totalLE = 0;
+  uint32_t fixes = 0;
+  std::ofstream estimates;
+  if (!estimatesFile.empty ())
+    {
+      estimates.open (estimatesFile.c_str ());
+      estimates << "id,x,y,isBeacon,estX,estY,error" << std::endl;
+    }
+  // Back to the file order, line[l] being the index of the node on line l
+  std::vector<uint32_t> line (n);
+  for (uint32_t i = 0; i < n; ++i)
+    line[id[i]] = i;
+  for (uint32_t l = 0; l < n; ++l)
+    {
+      uint32_t i = line[l];
+      double error = -1;
+      if (!isBeacon[i] && (estX[i] != -1.0 || estY[i] != -1.0))
+        {
+          error = std::sqrt ((estX[i] - x[i]) * (estX[i] - x[i]) + (estY[i] - y[i]) * (estY[i] - y[i]));
+          totalLE += error;
+          fixes++;
+        }
+      if (estimates.is_open ())
+        estimates << l << "," << x[i] << "," << y[i] << "," << isBeacon[i] << ","
+                  << estX[i] << "," << estY[i] << "," << error << "\n";
+    }
+
+  // Same layout as dvhop_report.csv, every node is alive
+  std::ofstream reportStream;
+  if (!reportFile.empty ())
+    reportStream.open (reportFile.c_str ());
+  std::ostream &report = reportFile.empty () ? std::cout : reportStream;
+  report << reportTime << ",\t" << n << ",\t" << fixes << ",\t";
+  if (fixes > 0)
+    report << totalLE / fixes << std::endl;
+  else
+    report << "NaN" << std::endl;   // As DVHopStatistics when no node has a position
+  return 0;
+}
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+    Scalability benchmark for the DV-Hop module.
+
+    Runs the dvhop-example scenario (random placement, 25 m range, a share of
+    beacons) for several node counts at constant density: the field grows so
+    that every size has the density of 100 nodes on 100 m x 100 m. Each size
+    runs in its own forked process so peak RSS is measured per size.
+
+    One CSV row per size is written to --output (stdout by default):
+      nodes,field_m,sim_time_s,wall_s,events,events_per_s,peak_rss_kb,
+      packets_per_node,converged,convergence_s
+
+    --channel=unitdisk replaces the Wi-Fi stack with dvhop::UnitDiskChannel.
+
+    ./waf --run "dvhop-scaling-benchmark --sizes=100,1000,5000,20000 --output=scaling.csv"
+*/
+
+#include "ns3/dvhop-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace {
+
+  // Density of the reference scenario: 100 nodes on 100 m x 100 m
+  const double REFERENCE_NODES = 100;
+  const double REFERENCE_FIELD = 100;
+
+  struct BenchmarkConfig
+  {
+    double   time;
+    double   range;
+    std::string channel;
+    uint32_t beaconPercentage;
+    uint32_t stableIntervals;
+  };
+
+  uint64_t g_packetsSent = 0;
+
+  void
+  CountTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+  {
+    g_packetsSent++;
+  }
+
+  /**
+   * Runs one size and returns its CSV row (without the trailing newline)
+   */
+  std::string
+  RunSize (uint32_t size, const BenchmarkConfig &config)
+  {
+    double field = REFERENCE_FIELD * std::sqrt (size / REFERENCE_NODES);
+
+    NodeContainer nodes;
+    nodes.Create (size);
+
+    std::ostringstream bounds;
+    bounds << "ns3::UniformRandomVariable[Min=0|Max=" << field << "]";
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator ("ns3::RandomRectanglePositionAllocator",
+                                   "X", StringValue (bounds.str ()),
+                                   "Y", StringValue (bounds.str ()));
+    mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+    mobility.Install (nodes);
+
+    NetDeviceContainer devices;
+    if (config.channel == "unitdisk")
+      {
+        Ptr<dvhop::UnitDiskChannel> unitDisk = CreateObject<dvhop::UnitDiskChannel> ();
+        unitDisk->SetAttribute ("Range", DoubleValue (config.range));
+        SimpleNetDeviceHelper simple;
+        devices = simple.Install (nodes, unitDisk);
+      }
+    else
+      {
+        WifiMacHelper wifiMac;
+        wifiMac.SetType ("ns3::AdhocWifiMac");
+        YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+        YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
+        wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+        wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (config.range));
+        wifiPhy.SetChannel (wifiChannel.Create ());
+        WifiHelper wifi;
+        wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+        wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue ("OfdmRate6Mbps"),
+                                      "RtsCtsThreshold", UintegerValue (0));
+        devices = wifi.Install (wifiPhy, wifiMac, nodes);
+      }
+
+    DVHopHelper dvhop;
+    dvhop.Set ("FieldWidth", DoubleValue (field));
+    dvhop.Set ("FieldHeight", DoubleValue (field));
+    InternetStackHelper stack;
+    stack.SetRoutingHelper (dvhop);
+    stack.Install (nodes);
+    Ipv4AddressHelper address;
+    address.SetBase ("10.0.0.0", "255.0.0.0");
+    address.Assign (devices);
+
+    // The first nodes are beacons, positions are already random
+    uint32_t beaconCount = (config.beaconPercentage * size) / 100;
+    for (uint32_t i = 0; i < beaconCount; ++i)
+      {
+        Ptr<dvhop::RoutingProtocol> proto =
+          DynamicCast<dvhop::RoutingProtocol> (nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+        Vector pos = nodes.Get (i)->GetObject<MobilityModel> ()->GetPosition ();
+        proto->SetIsBeacon (true);
+        proto->SetPosition (pos.x, pos.y);
+      }
+
+    Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/Tx", MakeCallback (&CountTx));
+
+    Ptr<DVHopConvergenceMonitor> monitor = CreateObject<DVHopConvergenceMonitor> ();
+    monitor->SetAttribute ("StableIntervals", UintegerValue (config.stableIntervals));
+    monitor->Install (nodes);
+
+    Simulator::Stop (Seconds (config.time));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+    Simulator::Run ();
+    double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+    double simTime = Simulator::Now ().GetSeconds ();
+    uint64_t events = Simulator::GetEventCount ();
+
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+
+    std::ostringstream row;
+    row << size << "," << field << "," << simTime << "," << wall << "," << events << ","
+        << (wall > 0 ? events / wall : 0) << "," << usage.ru_maxrss << ","
+        << double (g_packetsSent) / size << "," << monitor->IsConverged () << ",";
+    if (monitor->IsConverged ())
+      row << monitor->GetConvergenceTime ().GetSeconds ();
+    else
+      row << "NaN";
+
+    Simulator::Destroy ();
+    return row.str ();
+  }
+
+}
+
+int
+main (int argc, char **argv)
+{
+  std::string sizes = "100,1000,5000,20000";
+  std::string output;
+  BenchmarkConfig config;
+  config.time = 60;
+  config.range = 25.0;
+  config.channel = "wifi";
+  config.beaconPercentage = 25;
+  config.stableIntervals = 3;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "Comma separated node counts.", sizes);
+  cmd.AddValue ("time", "Simulation time cap, s. Runs stop earlier once converged.", config.time);
+  cmd.AddValue ("range", "Radio range, m.", config.range);
+  cmd.AddValue ("channel", "Link layer: wifi or unitdisk.", config.channel);
+  cmd.AddValue ("beaconPercentage", "Percentage of beacons.", config.beaconPercentage);
+  cmd.AddValue ("stableIntervals", "HELLO intervals without change before the network is considered stable.", config.stableIntervals);
+  cmd.AddValue ("output", "CSV file, stdout if empty.", output);
+  cmd.Parse (argc, argv);
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file)
+        NS_FATAL_ERROR ("Cannot open " << output);
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+  os << "nodes,field_m,sim_time_s,wall_s,events,events_per_s,peak_rss_kb,packets_per_node,converged,convergence_s"
+     << std::endl;
+
+  std::istringstream list (sizes);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      uint32_t size = std::strtoul (item.c_str (), 0, 10);
+      if (size == 0)
+        continue;
+
+      // One process per size so that peak RSS and simulator state do not carry over
+      int fds[2];
+      if (pipe (fds) != 0)
+        NS_FATAL_ERROR ("pipe failed");
+      std::cout.flush ();
+      pid_t pid = fork ();
+      if (pid < 0)
+        NS_FATAL_ERROR ("fork failed");
+      if (pid == 0)
+        {
+          close (fds[0]);
+          std::string row = RunSize (size, config) + "\n";
+          if (write (fds[1], row.c_str (), row.size ()) < 0)
+            _exit (1);
+          close (fds[1]);
+          _exit (0);
+        }
+
+      close (fds[1]);
+      std::string row;
+      char buffer[256];
+      ssize_t n;
+      while ((n = read (fds[0], buffer, sizeof (buffer))) > 0)
+        row.append (buffer, n);
+      close (fds[0]);
+      int status = 0;
+      waitpid (pid, &status, 0);
+
+      if (WIFEXITED (status) && WEXITSTATUS (status) == 0 && !row.empty ())
+        os << row << std::flush;
+      else // Killed, e.g. out of memory: keep the row so the failure shows in diffs
+        os << size << ",NaN,NaN,NaN,NaN,NaN,NaN,NaN,0,NaN" << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+"""
+Parallel parameter sweep for dvhop-example.
+
+Every (size, beacon percentage, critical, run) combination is an independent
+simulation process with its own working directory and RngRun, so runs never
+overwrite each other's nodes.csv / dvhop.distances and all cores stay busy.
+The report CSVs of all runs are merged into one long-format CSV with
+the mean and 95% confidence interval of every metric per configuration:
+
+    size,beacons,critical,time,metric,n,mean,ci95
+
+Example, from the ns-3 root after ./waf configure --enable-examples && ./waf:
+
+    ./src/dvhop/examples/dvhop-sweep.py --sizes 100 --beacons 3 15 25 40 \\
+        --critical both --runs 10 --out sweep
+"""
+
+import argparse
+import csv
+import glob
+import itertools
+import math
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+# Two sided 95% Student t quantiles for 1 to 30 degrees of freedom
+T95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+
+def find_binary(ns3_dir):
+    candidates = glob.glob(os.path.join(ns3_dir, 'build', '**', '*dvhop-example*'), recursive=True)
+    candidates = [c for c in candidates if os.access(c, os.X_OK) and not os.path.isdir(c)]
+    if not candidates:
+        sys.exit('dvhop-example not found under %s/build, build ns-3 with --enable-examples or use --binary'
+                 % ns3_dir)
+    return sorted(candidates, key=len)[0]
+
+
+METRICS = ['alive', 'fixes', 'avg_le', 'median_le', 'p90_le', 'p95_le']
+
+
+def parse_report(path):
+    """Returns [(time, alive, fixes, average LE, median LE, 90th LE, 95th LE)] from the example's report CSV.
+
+    Reports of older builds only have the first four columns, their percentiles are NaN."""
+    rows = []
+    with open(path) as f:
+        for line in f:
+            fields = [v.strip() for v in line.split(',')]
+            if len(fields) < 4:
+                continue
+            fixes = int(fields[2])
+            # The errors are NaN (-nan in older reports) when no node has a position yet
+            errors = [float(v) if fixes > 0 else float('nan') for v in fields[3:7]]
+            errors += [float('nan')] * (4 - len(errors))
+            rows.append(tuple([round(float(fields[0]), 9), int(fields[1]), fixes] + errors))
+    return rows
+
+
+def run_one(args, binary, env, config, run):
+    size, beacons, critical = config
+    run_dir = os.path.join(args.out, 'size-%d_beacons-%d_crit-%d' % config, 'run-%d' % run)
+    os.makedirs(run_dir, exist_ok=True)
+    cmd = [binary,
+           '--size=%d' % size,
+           '--beaconPercentage=%d' % beacons,
+           '--critical=%d' % critical,
+           '--time=%g' % args.time,
+           '--reportFile=dvhop_report.csv',
+           '--animFile=',
+           '--RngRun=%d' % run] + args.extra
+    with open(os.path.join(run_dir, 'stdout.log'), 'w') as log:
+        proc = subprocess.run(cmd, stdin=subprocess.DEVNULL, stdout=log, stderr=subprocess.STDOUT,
+                              cwd=run_dir, env=env)
+    if proc.returncode != 0:
+        raise RuntimeError('%s exited with %d, see %s/stdout.log' % (' '.join(cmd), proc.returncode, run_dir))
+    return config, run, parse_report(os.path.join(run_dir, 'dvhop_report.csv'))
+
+
+def mean_ci(values):
+    values = [v for v in values if v is not None and not math.isnan(v)]
+    n = len(values)
+    if n == 0:
+        return 0, float('nan'), float('nan')
+    mean = sum(values) / n
+    if n == 1:
+        return n, mean, float('nan')
+    var = sum((v - mean) ** 2 for v in values) / (n - 1)
+    t = T95[n - 2] if n - 1 <= len(T95) else 1.96
+    return n, mean, t * math.sqrt(var / n)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--sizes', type=int, nargs='+', default=[100], help='node counts')
+    parser.add_argument('--beacons', type=int, nargs='+', default=[25], help='beacon percentages')
+    parser.add_argument('--critical', choices=['off', 'on', 'both'], default='off', help='critical mode')
+    parser.add_argument('--runs', type=int, default=10, help='RngRun values 1..RUNS per configuration')
+    parser.add_argument('--time', type=float, default=10, help='simulation time, s')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(), help='parallel simulations')
+    parser.add_argument('--out', default='dvhop-sweep', help='output directory')
+    parser.add_argument('--ns3-dir', default='.', help='ns-3 root, used to find the example binary')
+    parser.add_argument('--binary', help='dvhop-example executable')
+    parser.add_argument('extra', nargs='*', help='further arguments for every run, after --')
+    args = parser.parse_args()
+
+    binary = os.path.abspath(args.binary or find_binary(args.ns3_dir))
+    env = dict(os.environ)
+    lib_dir = os.path.abspath(os.path.join(args.ns3_dir, 'build', 'lib'))
+    env['LD_LIBRARY_PATH'] = lib_dir + os.pathsep + env.get('LD_LIBRARY_PATH', '')
+
+    critical = {'off': [False], 'on': [True], 'both': [False, True]}[args.critical]
+    configs = list(itertools.product(args.sizes, args.beacons, [int(c) for c in critical]))
+    jobs = [(config, run) for config in configs for run in range(1, args.runs + 1)]
+    os.makedirs(args.out, exist_ok=True)
+    print('%d configurations x %d runs on %d workers' % (len(configs), args.runs, args.jobs))
+
+    # samples[(config, time)] = [(alive, fixes, avg, median, p90, p95 LE)] over runs
+    samples = {}
+    failures = 0
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run_one, args, binary, env, config, run) for config, run in jobs]
+        for done, future in enumerate(as_completed(futures), 1):
+            try:
+                config, run, rows = future.result()
+            except RuntimeError as e:
+                failures += 1
+                print(e, file=sys.stderr)
+                continue
+            for row in rows:
+                samples.setdefault((config, row[0]), []).append(row[1:])
+            print('[%d/%d] size=%d beacons=%d critical=%d run=%d' % ((done, len(jobs)) + config + (run,)))
+
+    report = os.path.join(args.out, 'dvhop_sweep.csv')
+    with open(report, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['size', 'beacons', 'critical', 'time', 'metric', 'n', 'mean', 'ci95'])
+        for (config, time) in sorted(samples):
+            values = samples[(config, time)]
+            for k, metric in enumerate(METRICS):
+                n, mean, ci = mean_ci([v[k] for v in values])
+                writer.writerow(list(config) + [time, metric, n, mean, ci])
+    print('Wrote %s' % report)
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "dvhop-convergence-monitor.h"
+#include "ns3/dvhop.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+  NS_LOG_COMPONENT_DEFINE ("DVHopConvergenceMonitor");
+
+  NS_OBJECT_ENSURE_REGISTERED (DVHopConvergenceMonitor);
+
+  TypeId
+  DVHopConvergenceMonitor::GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::DVHopConvergenceMonitor")
+        .SetParent<Object> ()
+        .AddConstructor<DVHopConvergenceMonitor> ()
+        .AddAttribute ("CheckInterval",
+                       "Time between two samples, usually the HELLO interval.",
+                       TimeValue (Seconds (1)),
+                       MakeTimeAccessor (&DVHopConvergenceMonitor::m_checkInterval),
+                       MakeTimeChecker ())
+        .AddAttribute ("StableIntervals",
+                       "Number of consecutive samples without change before the network is converged.",
+                       UintegerValue (3),
+                       MakeUintegerAccessor (&DVHopConvergenceMonitor::m_stableIntervals),
+                       MakeUintegerChecker<uint32_t> (1))
+        .AddAttribute ("StopOnConvergence",
+                       "Stop the simulation once the network converged.",
+                       BooleanValue (true),
+                       MakeBooleanAccessor (&DVHopConvergenceMonitor::m_stopOnConvergence),
+                       MakeBooleanChecker ());
+    return tid;
+  }
+
+  DVHopConvergenceMonitor::DVHopConvergenceMonitor () :
+    m_checkTimer (Timer::CANCEL_ON_DESTROY),
+    m_checkInterval (Seconds (1)),
+    m_stableIntervals (3),
+    m_stopOnConvergence (true),
+    m_stableCount (0),
+    m_converged (false),
+    m_convergenceTime (Seconds (0)),
+    m_nodesWithFix (0),
+    m_estimateMoves (0),
+    m_lastChange (Seconds (0))
+  {
+  }
+
+  DVHopConvergenceMonitor::~DVHopConvergenceMonitor ()
+  {
+  }
+
+  void
+  DVHopConvergenceMonitor::DoDispose ()
+  {
+    m_checkTimer.Cancel ();
+    m_nodes = NodeContainer ();
+    Object::DoDispose ();
+  }
+
+  void
+  DVHopConvergenceMonitor::Install (NodeContainer c)
+  {
+    m_nodes.Add (c);
+    m_checkTimer.SetFunction (&DVHopConvergenceMonitor::Check, this);
+    m_checkTimer.Cancel ();
+    m_checkTimer.Schedule (m_checkInterval);
+  }
+
+  void
+  DVHopConvergenceMonitor::Check ()
+  {
+    Time lastChange = Seconds (0);
+    uint32_t nodesWithFix = 0;
+    uint32_t estimateMoves = 0;
+    for (NodeContainer::Iterator i = m_nodes.Begin (); i != m_nodes.End (); ++i)
+      {
+        Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+        NS_ASSERT_MSG (ipv4, "Ipv4 not installed on node");
+        Ptr<dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol> (ipv4->GetRoutingProtocol ());
+        NS_ASSERT_MSG (dvhop, "DV-Hop not installed on node");
+
+        lastChange = std::max (lastChange, dvhop->GetLastChange ());
+        estimateMoves += dvhop->GetEstimateMoves ();
+        if (dvhop->HasPositionFix ())
+          {
+            nodesWithFix++;
+          }
+      }
+
+    // Nothing received yet is not convergence, unless the tables were injected at start
+    if ((lastChange > Seconds (0) || estimateMoves > 0) && lastChange == m_lastChange)
+      {
+        m_stableCount++;
+      }
+    else
+      {
+        m_stableCount = 0;
+      }
+    m_lastChange = lastChange;
+    m_nodesWithFix = nodesWithFix;
+    m_estimateMoves = estimateMoves;
+
+    NS_LOG_LOGIC ("@" << Simulator::Now ().GetSeconds () << " last change " << lastChange.GetSeconds ()
+                  << " s, " << nodesWithFix << " fixes, " << estimateMoves << " estimate moves");
+
+    // A later change cancels the convergence until the network settles again
+    m_converged = m_stableCount >= m_stableIntervals;
+    if (m_converged)
+      {
+        m_convergenceTime = lastChange;
+        NS_LOG_INFO ("Converged at " << lastChange.GetSeconds () << " s");
+        if (m_stopOnConvergence)
+          {
+            Simulator::Stop ();
+            return;
+          }
+      }
+    m_checkTimer.Schedule (m_checkInterval);
+  }
+
+}
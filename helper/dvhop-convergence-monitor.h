@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DVHOP_CONVERGENCE_MONITOR_H
+#define DVHOP_CONVERGENCE_MONITOR_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/timer.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+  /**
+   * @brief The DVHopConvergenceMonitor class samples the DV-Hop state of a set
+   * of nodes every CheckInterval and declares the network converged once no
+   * table changed and no estimate moved for StableIntervals samples in a row.
+   *
+   * The convergence time is the time of the last change before the stable
+   * period. When StopOnConvergence is set the simulation stops right away.
+   */
+  class DVHopConvergenceMonitor : public Object
+  {
+  public:
+    static TypeId GetTypeId (void);
+
+    DVHopConvergenceMonitor ();
+    virtual ~DVHopConvergenceMonitor ();
+
+    /**
+     * @brief Install Starts monitoring the nodes, which must run dvhop::RoutingProtocol
+     * @param c The nodes
+     */
+    void Install (NodeContainer c);
+
+    bool     IsConverged () const          { return m_converged; }
+    /// Time of the last change of the network, only meaningful once converged
+    Time     GetConvergenceTime () const   { return m_convergenceTime; }
+    /// Latest samples, updated every CheckInterval
+    uint32_t GetNodesWithFix () const      { return m_nodesWithFix; }
+    uint32_t GetEstimateMoves () const     { return m_estimateMoves; }
+    Time     GetLastChange () const        { return m_lastChange; }
+
+  protected:
+    virtual void DoDispose ();
+
+  private:
+    void Check ();
+
+    NodeContainer m_nodes;
+    Timer    m_checkTimer;
+
+    // Attributes
+    Time     m_checkInterval;
+    uint32_t m_stableIntervals;
+    bool     m_stopOnConvergence;
+
+    // Samples
+    uint32_t m_stableCount;
+    bool     m_converged;
+    Time     m_convergenceTime;
+    uint32_t m_nodesWithFix;
+    uint32_t m_estimateMoves;
+    Time     m_lastChange;
+  };
+
+}
+
+#endif /* DVHOP_CONVERGENCE_MONITOR_H */
@@ -8,7 +8,10 @@
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/node.h"
 #include "ns3/simulator.h"
-#include "ns3/dvhop.h"
+#include "ns3/mobility-model.h"
+#include "ns3/unit-disk-graph.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -92,5 +95,120 @@ namespace ns3 {
     // Print node information to output stream
     rp->PrintDistances(stream, node);
   }
-}
 
+  // Returns the routing protocol of a node, which must run DV-Hop
+  static Ptr<dvhop::RoutingProtocol>
+  GetDVHop (Ptr<Node> node)
+  {
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+    NS_ASSERT_MSG (ipv4, "Ipv4 not installed on node");
+    Ptr<dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol> (ipv4->GetRoutingProtocol ());
+    NS_ASSERT_MSG (dvhop, "DV-Hop not installed on node");
+    return dvhop;
+  }
+
+  void
+  DVHopHelper::WarmStart (NodeContainer c, double range) const
+  {
+    uint32_t n = c.GetN ();
+    std::vector<Ptr<dvhop::RoutingProtocol> > protocols (n);
+    std::vector<double> x (n), y (n);
+    std::vector<uint32_t> beacons;
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        protocols[i] = GetDVHop (c.Get (i));
+        Ptr<MobilityModel> mobility = c.Get (i)->GetObject<MobilityModel> ();
+        NS_ASSERT_MSG (mobility, "Warm start needs a MobilityModel on every node");
+        x[i] = mobility->GetPosition ().x;
+        y[i] = mobility->GetPosition ().y;
+        if (protocols[i]->IsBeacon ())
+          beacons.push_back (i);
+      }
+
+    dvhop::UnitDiskGraph graph;
+    graph.Build (x, y, range);
+
+    // Entries of every node: (hops, beacon), sorted by hops so tables are in discovery order
+    std::vector<std::vector<std::pair<uint16_t, uint32_t> > > entries (n);
+    std::vector<double> hopSizes (beacons.size (), -1.0);
+    std::vector<uint16_t> hops;
+    for (uint32_t b = 0; b < beacons.size (); ++b)
+      {
+        uint32_t source = beacons[b];
+        graph.HopCounts (source, hops);
+
+        // Hop size as in RecalculateHopSize, from the advertised beacon positions
+        double distSum = 0, hopSum = 0;
+        for (uint32_t k = 0; k < beacons.size (); ++k)
+          {
+            uint32_t other = beacons[k];
+            if (other == source || hops[other] == dvhop::UnitDiskGraph::UNREACHABLE)
+              continue;
+            double dx = protocols[other]->GetXPosition () - protocols[source]->GetXPosition ();
+            double dy = protocols[other]->GetYPosition () - protocols[source]->GetYPosition ();
+            distSum += std::sqrt (dx * dx + dy * dy);
+            hopSum += hops[other];
+          }
+        if (hopSum > 0)
+          hopSizes[b] = distSum / hopSum;
+
+        for (uint32_t i = 0; i < n; ++i)
+          {
+            if (i != source && hops[i] != dvhop::UnitDiskGraph::UNREACHABLE)
+              entries[i].push_back (std::make_pair (hops[i], b));
+          }
+      }
+
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        std::sort (entries[i].begin (), entries[i].end ());
+        for (uint32_t k = 0; k < entries[i].size (); ++k)
+          {
+            uint32_t b = entries[i][k].second;
+            Ptr<dvhop::RoutingProtocol> beacon = protocols[beacons[b]];
+            protocols[i]->InjectBeacon (beacon->GetBeaconAddress (), entries[i][k].first, hopSizes[b],
+                                        beacon->GetXPosition (), beacon->GetYPosition ());
+          }
+        protocols[i]->FinishWarmStart ();
+      }
+  }
+
+  dvhop::ProtocolCounters
+  DVHopHelper::SumCounters (NodeContainer c) const
+  {
+    dvhop::ProtocolCounters sum;
+    bool allFixed = true;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<dvhop::RoutingProtocol> dvhop = GetDVHop (*i);
+        sum += dvhop->GetCounters ();
+        // Beacons know their position without a fix
+        if (!dvhop->IsBeacon () && dvhop->GetCounters ().firstFix.IsStrictlyNegative ())
+          allFixed = false;
+      }
+    if (!allFixed)
+      sum.firstFix = Seconds (-1);
+    return sum;
+  }
+
+  void
+  DVHopHelper::PrintCounters (NodeContainer c, std::ostream &os) const
+  {
+    os << "node,beacon,hellos_sent,hello_bytes_sent,packets_received,hellos_lost,duplicates,suppressed_entries,"
+       << "table_inserts,table_improvements,solver_runs,solver_failures,first_fix_s\n";
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<dvhop::RoutingProtocol> dvhop = GetDVHop (*i);
+        const dvhop::ProtocolCounters &counters = dvhop->GetCounters ();
+        os << (*i)->GetId () << "," << dvhop->IsBeacon () << "," << counters.hellosSent << ","
+           << counters.helloBytesSent << "," << counters.packetsReceived << "," << counters.hellosLost << ","
+           << counters.duplicates << "," << counters.suppressedEntries << "," << counters.tableInserts << ","
+           << counters.tableImprovements << "," << counters.solverRuns << "," << counters.solverFailures << ",";
+        if (counters.firstFix.IsStrictlyNegative ())
+          os << "NaN\n";
+        else
+          os << counters.firstFix.GetSeconds () << "\n";
+      }
+    os.flush ();
+  }
+}
@@ -23,6 +23,9 @@
 		Set			-- sets the name and attribute value of the agentFactory pdm
 		AssignStreams		-- installs Ipv4 and routing to nodes add new streams to current DVHop stream
 		PrintDistanceTableAllAt -- prints the distance table and times
+		WarmStart		-- fills every distance table with its converged state before the simulation starts
+		SumCounters		-- adds up the protocol counters of a set of nodes
+		PrintCounters		-- writes the protocol counters of every node as CSV
 
 
 */
@@ -41,6 +44,9 @@ namespace ns3 {
   //Forward declarations -- indicate needed classes for the class to work properly
   class Node;			// Node object
   class Ipv4RoutingProtocol;	// IP Protocol
+  namespace dvhop {
+    struct ProtocolCounters;	// Per node counters
+  }
 
 
   class DVHopHelper : public Ipv4RoutingHelper
@@ -73,6 +79,26 @@ namespace ns3 {
      */
     void PrintDistanceTableAllAt (Time printTime, Ptr<OutputStreamWrapper> stream) const;
 
+    /**
+     *Warm start: computes the converged hop counts and beacon hop sizes from the
+     *mobility positions, assuming unit disk links of the given range, and stores
+     *them in every node's distance table. Call after the addresses are assigned
+     *and the beacons are set, before Simulator::Run
+     */
+    void WarmStart (NodeContainer c, double range) const;
+
+    /**
+     *Adds up the protocol counters of the nodes. The first fix of the sum is
+     *the latest first fix of the regular nodes, negative if one has none
+     */
+    dvhop::ProtocolCounters SumCounters (NodeContainer c) const;
+
+    /**
+     *Writes one CSV row of protocol counters per node, after a header row, to
+     *find the nodes that carry most of the control overhead
+     */
+    void PrintCounters (NodeContainer c, std::ostream &os) const;
+
   private:
     void Print (Ptr<Node> node, Ptr<OutputStreamWrapper> stream) const;
 
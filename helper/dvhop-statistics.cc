@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "dvhop-statistics.h"
+#include "ns3/dvhop.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/mobility-model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+  NS_LOG_COMPONENT_DEFINE ("DVHopStatistics");
+
+  NS_OBJECT_ENSURE_REGISTERED (DVHopStatistics);
+
+  TypeId
+  DVHopStatistics::GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::DVHopStatistics")
+        .SetParent<Object> ()
+        .AddConstructor<DVHopStatistics> ()
+        .AddAttribute ("ReportInterval",
+                       "Time between two report rows.",
+                       TimeValue (Seconds (1)),
+                       MakeTimeAccessor (&DVHopStatistics::m_reportInterval),
+                       MakeTimeChecker ())
+        .AddAttribute ("ReportFile",
+                       "File of the report rows, empty for none. Set before Install.",
+                       StringValue (""),
+                       MakeStringAccessor (&DVHopStatistics::m_reportFile),
+                       MakeStringChecker ())
+        .AddAttribute ("DetailFile",
+                       "File of the per node rows, empty for none. Set before Install.",
+                       StringValue (""),
+                       MakeStringAccessor (&DVHopStatistics::m_detailFile),
+                       MakeStringChecker ())
+        .AddAttribute ("BinWidth",
+                       "Width of the localization error histogram bins, in meters.",
+                       DoubleValue (0.1),
+                       MakeDoubleAccessor (&DVHopStatistics::m_binWidth),
+                       MakeDoubleChecker<double> (std::numeric_limits<double>::min ()));
+    return tid;
+  }
+
+  DVHopStatistics::DVHopStatistics () :
+    m_reportTimer (Timer::CANCEL_ON_DESTROY),
+    m_reportInterval (Seconds (1)),
+    m_binWidth (0.1),
+    m_alive (0),
+    m_regular (0),
+    m_fixes (0),
+    m_errorSum (0)
+  {
+  }
+
+  DVHopStatistics::~DVHopStatistics ()
+  {
+  }
+
+  void
+  DVHopStatistics::DoDispose ()
+  {
+    m_reportTimer.Cancel ();
+    m_report.close ();
+    m_detail.close ();
+    Object::DoDispose ();
+  }
+
+  void
+  DVHopStatistics::Install (NodeContainer c)
+  {
+    if (!m_reportFile.empty () && !m_report.is_open ())
+      {
+        m_report.open (m_reportFile.c_str ());
+        if (!m_report)
+          NS_FATAL_ERROR ("Cannot open " << m_reportFile);
+      }
+    if (!m_detailFile.empty () && !m_detail.is_open ())
+      {
+        m_detail.open (m_detailFile.c_str ());
+        if (!m_detail)
+          NS_FATAL_ERROR ("Cannot open " << m_detailFile);
+      }
+
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+        NS_ASSERT_MSG (ipv4, "Ipv4 not installed on node");
+        Ptr<dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol> (ipv4->GetRoutingProtocol ());
+        NS_ASSERT_MSG (dvhop, "DV-Hop not installed on node");
+        Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+        NS_ASSERT_MSG (mobility, "Mobility not installed on node");
+
+        uint32_t index = m_nodes.size ();
+        NodeState node;
+        node.beacon = dvhop->IsBeacon ();
+        node.alive = dvhop->IsAlive ();
+        node.x = mobility->GetPosition ().x;
+        node.y = mobility->GetPosition ().y;
+        node.estimate = dvhop::Position (-1.0, -1.0);
+        node.error = -1.0;
+        m_alive += node.alive;
+        m_regular += !node.beacon;
+
+        m_nodes.push_back (node);
+
+        // The estimate may already exist, e.g. after a warm start
+        if (!node.beacon && dvhop->HasPositionFix ())
+          {
+            EstimateChanged (this, index, node.estimate, dvhop->GetEstimatedPosition ());
+          }
+        dvhop->TraceConnectWithoutContext ("PositionEstimate",
+                                           MakeBoundCallback (&DVHopStatistics::EstimateChanged, this, index));
+        dvhop->TraceConnectWithoutContext ("NodeDied", MakeBoundCallback (&DVHopStatistics::NodeDied, this, index));
+      }
+
+    m_reportTimer.SetFunction (&DVHopStatistics::Report, this);
+    m_reportTimer.Cancel ();
+    m_reportTimer.Schedule (m_reportInterval);
+  }
+
+  void
+  DVHopStatistics::EstimateChanged (DVHopStatistics *stats, uint32_t node, dvhop::Position oldPosition,
+                                    dvhop::Position newPosition)
+  {
+    NodeState &state = stats->m_nodes[node];
+    if (state.beacon)
+      {
+        return;
+      }
+    state.estimate = newPosition;
+    double dx = newPosition.first - state.x;
+    double dy = newPosition.second - state.y;
+    stats->SetError (state, std::sqrt (dx * dx + dy * dy));
+  }
+
+  void
+  DVHopStatistics::NodeDied (DVHopStatistics *stats, uint32_t node)
+  {
+    NodeState &state = stats->m_nodes[node];
+    if (state.alive)
+      {
+        state.alive = false;
+        stats->m_alive--;
+      }
+  }
+
+  void
+  DVHopStatistics::SetError (NodeState &node, double error)
+  {
+    if (node.error >= 0)
+      {
+        m_fixes--;
+        m_errorSum -= node.error;
+        m_histogram[uint32_t (node.error / m_binWidth)]--;
+      }
+    node.error = error;
+    if (error >= 0)
+      {
+        m_fixes++;
+        m_errorSum += error;
+        uint32_t bin = error / m_binWidth;
+        if (bin >= m_histogram.size ())
+          {
+            m_histogram.resize (bin + 1, 0);
+          }
+        m_histogram[bin]++;
+      }
+  }
+
+  double
+  DVHopStatistics::GetAverageError () const
+  {
+    if (m_fixes == 0)
+      {
+        return std::numeric_limits<double>::quiet_NaN ();
+      }
+    // The running sum may drift slightly below zero once every error went back to zero
+    return std::max (0.0, m_errorSum / m_fixes);
+  }
+
+  double
+  DVHopStatistics::GetErrorPercentile (double p) const
+  {
+    if (m_fixes == 0)
+      {
+        return std::numeric_limits<double>::quiet_NaN ();
+      }
+    // Smallest bin that holds the ceil(p * fixes)-th error, reported at its center
+    uint32_t rank = std::max (1.0, std::ceil (p * m_fixes));
+    uint32_t count = 0;
+    for (uint32_t bin = 0; bin < m_histogram.size (); ++bin)
+      {
+        count += m_histogram[bin];
+        if (count >= rank)
+          {
+            return (bin + 0.5) * m_binWidth;
+          }
+      }
+    return (m_histogram.size () - 0.5) * m_binWidth;
+  }
+
+  void
+  DVHopStatistics::Report ()
+  {
+    double now = Simulator::Now ().GetSeconds ();
+    NS_LOG_LOGIC ("@" << now << " " << m_alive << " alive, " << m_fixes << "/" << m_regular
+                  << " fixes, average LE " << GetAverageError ());
+
+    if (m_report.is_open ())
+      {
+        // Same layout as the reports in Matlab/, no flush per row
+        m_report << now << ",\t" << m_alive << ",\t" << m_fixes;
+        if (m_fixes > 0)
+          {
+            m_report << ",\t" << GetAverageError () << ",\t" << GetErrorPercentile (0.5)
+                     << ",\t" << GetErrorPercentile (0.9) << ",\t" << GetErrorPercentile (0.95) << "\n";
+          }
+        else
+          {
+            m_report << ",\tNaN,\tNaN,\tNaN,\tNaN\n";
+          }
+      }
+
+    if (m_detail.is_open ())
+      {
+        for (uint32_t i = 0; i < m_nodes.size (); ++i)
+          {
+            const NodeState &node = m_nodes[i];
+            m_detail << now << "," << i << "," << node.alive << ",";
+            if (node.beacon)
+              m_detail << node.x << "," << node.y << ",0\n";
+            else if (node.error >= 0)
+              m_detail << node.estimate.first << "," << node.estimate.second << "," << node.error << "\n";
+            else
+              m_detail << "NaN,NaN,NaN\n";
+          }
+      }
+
+    m_reportTimer.Schedule (m_reportInterval);
+  }
+
+}
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DVHOP_STATISTICS_H
+#define DVHOP_STATISTICS_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/timer.h"
+#include "ns3/node-container.h"
+#include "ns3/distance-table.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+  /**
+   * @brief The DVHopStatistics class keeps running aggregates of a DV-Hop
+   * simulation, updated from the routing protocol trace sources instead of
+   * polling every node: alive nodes, regular nodes with a position, and the
+   * mean and percentiles of their localization error (LE).
+   *
+   * Every ReportInterval one row is appended to ReportFile, in the layout of
+   * the reports in Matlab/ followed by the LE percentiles:
+   *   time, alive, fixes, average LE, median LE, 90th LE, 95th LE
+   * The LE columns are NaN while no node has a position. Percentiles come
+   * from a histogram with BinWidth wide bins. DetailFile, when set, gets one
+   * row per node and interval: time, node, alive, x, y, LE.
+   *
+   * Nodes must not move, the true position is read once at Install.
+   */
+  class DVHopStatistics : public Object
+  {
+  public:
+    static TypeId GetTypeId (void);
+
+    DVHopStatistics ();
+    virtual ~DVHopStatistics ();
+
+    /**
+     * @brief Install Starts collecting from the nodes, which must run dvhop::RoutingProtocol
+     * with their beacons already set
+     * @param c The nodes
+     */
+    void Install (NodeContainer c);
+
+    /// Current aggregates
+    uint32_t GetAlive () const          { return m_alive; }
+    uint32_t GetNodesWithFix () const   { return m_fixes; }
+    uint32_t GetRegularNodes () const   { return m_regular; }
+    /// Mean localization error of the nodes with a position, NaN if there is none
+    double   GetAverageError () const;
+    /**
+     * @brief GetErrorPercentile Localization error below which a share of the nodes with a position lie
+     * @param p The share, in [0, 1]
+     * @return The error, within BinWidth, or NaN if no node has a position
+     */
+    double   GetErrorPercentile (double p) const;
+
+  protected:
+    virtual void DoDispose ();
+
+  private:
+    // Per node state, indexed like the installed nodes
+    struct NodeState
+    {
+      bool   beacon;
+      bool   alive;
+      double x, y;           // True position
+      dvhop::Position estimate;
+      double error;          // Localization error, negative without a position
+    };
+
+    // Trace sinks, bound to the collector and the node index
+    static void EstimateChanged (DVHopStatistics *stats, uint32_t node, dvhop::Position oldPosition,
+                                 dvhop::Position newPosition);
+    static void NodeDied (DVHopStatistics *stats, uint32_t node);
+
+    // Moves a node's error in the running sum and the histogram, negative meaning no position
+    void SetError (NodeState &node, double error);
+    void Report ();
+
+    std::vector<NodeState> m_nodes;
+    Timer    m_reportTimer;
+    std::ofstream m_report;
+    std::ofstream m_detail;
+
+    // Attributes
+    Time        m_reportInterval;
+    std::string m_reportFile;
+    std::string m_detailFile;
+    double      m_binWidth;
+
+    // Running aggregates
+    uint32_t m_alive;
+    uint32_t m_regular;
+    uint32_t m_fixes;
+    double   m_errorSum;
+    std::vector<uint32_t> m_histogram;
+  };
+
+}
+
+#endif /* DVHOP_STATISTICS_H */
@@ -12,67 +12,133 @@ namespace ns3
     {
     }
 
-    // Returns the number of hops to get to the passed beacon
-    uint16_t
-    DistanceTable::GetHopsTo (Ipv4Address beacon) const
+    // Returns the entry of the passed beacon, or 0 if it is unknown
+    const BeaconInfo*
+    DistanceTable::Find (Ipv4Address beacon) const
     {
-      std::map<Ipv4Address, BeaconInfo>::const_iterator it = m_table.find (beacon);
-      if( it != m_table.end ())
+      std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it = m_index.find (beacon);
+      if( it != m_index.end ())
         {
-          return ((BeaconInfo)it->second).GetHops ();
+          return &m_entries[it->second];
         }
 
       else return 0;
     }
 
+    // Returns the slot of the passed beacon, or -1 if it is unknown
+    int32_t
+    DistanceTable::GetIndexOf (Ipv4Address beacon) const
+    {
+      std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it = m_index.find (beacon);
+      if( it != m_index.end ())
+        {
+          return it->second;
+        }
+
+      else return -1;
+    }
+
+    // Returns the number of hops to get to the passed beacon
+    uint16_t
+    DistanceTable::GetHopsTo (Ipv4Address beacon) const
+    {
+      const BeaconInfo *info = Find (beacon);
+      return info ? info->GetHops () : 0;
+    }
+
     // Returns the hop size of the passed beacon
     double
     DistanceTable::GetHopSizeOf (Ipv4Address beacon) const
     {
-      std::map<Ipv4Address, BeaconInfo>::const_iterator it = m_table.find (beacon);
-      if( it != m_table.end ())
-      {
-        return ((BeaconInfo)it->second).GetHopSize ();
-      }
-
-      else return -1.0;
+      const BeaconInfo *info = Find (beacon);
+      return info ? info->GetHopSize () : -1.0;
     }
 
     // Returns the position of the passed beacon
     Position
     DistanceTable::GetBeaconPosition (Ipv4Address beacon) const
     {
-      std::map<Ipv4Address, BeaconInfo>::const_iterator it = m_table.find (beacon);
-      if( it != m_table.end ())
-        {
-          return ((BeaconInfo)it->second).GetPosition ();
-        }
-
-      else return Position(-1.0,-1.0);
+      const BeaconInfo *info = Find (beacon);
+      return info ? info->GetPosition () : Position(-1.0,-1.0);
     }
 
     // Adds a new Beacon to the data table, assigning its BeaconInfo
-    void
+    uint32_t
     DistanceTable::AddBeacon (Ipv4Address beacon, uint16_t hops, double hopSize, double xPos, double yPos)
     {
-      std::map<Ipv4Address, BeaconInfo>::iterator it = m_table.find (beacon);
-      BeaconInfo info;
-      if( it != m_table.end ())
+      std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it = m_index.find (beacon);
+      if( it != m_index.end ())
         {
-          info.SetPosition (it->second.GetPosition ());
+          // The position of a beacon never changes, keep the first one
+          BeaconInfo &info = m_entries[it->second];
+          info.SetDirty (info.IsDirty () || info.GetHops () != hops || info.GetHopSize () != hopSize);
           info.SetHops (hops);
           info.SetHopSize(hopSize);
           info.SetTime (Simulator::Now ());
-          it->second = info;
+          return it->second;
         }
-      else
+
+      BeaconInfo info;
+      info.SetAddress (beacon);
+      info.SetHops (hops);
+      info.SetHopSize(hopSize);
+      info.SetPosition (Position(xPos, yPos));
+      info.SetTime (Simulator::Now ());
+      info.SetDirty (true);
+
+      uint32_t index = m_entries.size ();
+      m_entries.push_back (info);
+      m_index[beacon] = index;
+      return index;
+    }
+
+    bool
+    DistanceTable::AcceptsPath (Ipv4Address beacon, uint16_t hops, uint16_t seqNo, Time staleTimeout) const
+    {
+      const BeaconInfo *info = Find (beacon);
+      if (!info)
         {
-          info.SetHops (hops);
-          info.SetHopSize(hopSize);
-          info.SetPosition (Position(xPos, yPos));
-          info.SetTime (Simulator::Now ());
-	        m_table[beacon] = info;
-          //m_table.insert (std::pair<Ipv4Address, BeaconInfo>(beacon&, info));
+          return true;
+        }
+      if (IsNewerSequenceNumber (seqNo, info->GetSequenceNumber ()))
+        {// Fresher information: a longer path replaces the current one only once it went stale
+          return hops <= info->GetHops () || Simulator::Now () - info->GetRefreshTime () >= staleTimeout;
+        }
+      // Same round: update only when a shorter path is found
+      return seqNo == info->GetSequenceNumber () && hops < info->GetHops ();
+    }
+
+    // Stores the sequence number and time at which the hop count was confirmed.
+    // A new sequence number is advertised with the next triggered update, so
+    // downstream nodes do not time the entry out between full refreshes
+    void
+    DistanceTable::Refresh (Ipv4Address beacon, uint16_t seqNo)
+    {
+      std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it = m_index.find (beacon);
+      if( it != m_index.end ())
+        {
+          BeaconInfo &info = m_entries[it->second];
+          info.SetDirty (info.IsDirty () || info.GetSequenceNumber () != seqNo);
+          info.SetSequenceNumber (seqNo);
+          info.SetRefreshTime (Simulator::Now ());
+        }
+    }
+
+    // Returns whether the passed beacon changed since it was last advertised
+    bool
+    DistanceTable::IsDirty (Ipv4Address beacon) const
+    {
+      const BeaconInfo *info = Find (beacon);
+      return info ? info->IsDirty () : false;
+    }
+
+    // Marks every entry as advertised
+    void
+    DistanceTable::ClearDirty ()
+    {
+      for(std::vector<BeaconInfo>::iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+        {
+          j->SetDirty (false);
         }
     }
 
@@ -81,36 +147,73 @@ namespace ns3
     Time
     DistanceTable::LastUpdatedAt (Ipv4Address beacon) const
     {
-      std::map<Ipv4Address, BeaconInfo>::const_iterator it = m_table.find (beacon);
-      if( it != m_table.end ())
-        {
-          return ((BeaconInfo)it->second).GetTime ();
-        }
-
-      else return Time::Max ();
+      const BeaconInfo *info = Find (beacon);
+      return info ? info->GetTime () : Time::Max ();
     }
 
-    // Creates a linked list (as a stack) of each node for access
+    // Copies the address of each known beacon, in slot order
     std::vector<Ipv4Address>
     DistanceTable::GetKnownBeacons() const
     {
       std::vector<Ipv4Address> theBeacons;
-      for(std::map<Ipv4Address, BeaconInfo>::const_iterator j = m_table.begin (); j != m_table.end (); ++j)
+      theBeacons.reserve (m_entries.size ());
+      for(Iterator j = m_entries.begin (); j != m_entries.end (); ++j)
         {
-          theBeacons.push_back (j->first);
+          theBeacons.push_back (j->GetAddress ());
         }
       return theBeacons;
     }
 
+    static bool
+    CompareAddress (const BeaconInfo *a, const BeaconInfo *b)
+    {
+      return a->GetAddress () < b->GetAddress ();
+    }
+
+    uint32_t
+    DistanceTable::SelectLowestAddresses (const BeaconInfo **out, uint32_t n) const
+    {
+      // Insertion into the n lowest so far, n is small
+      uint32_t count = 0;
+      for (Iterator entry = m_entries.begin (); entry != m_entries.end (); ++entry)
+        {
+          if (entry->GetHopSize () < 0 || n == 0)
+            {
+              continue; // Ignore Beacon with no valid hop size
+            }
+          if (count == n && !(entry->GetAddress () < out[n - 1]->GetAddress ()))
+            {
+              continue;
+            }
+          uint32_t slot = count < n ? count++ : n - 1;
+          while (slot > 0 && entry->GetAddress () < out[slot - 1]->GetAddress ())
+            {
+              out[slot] = out[slot - 1];
+              slot--;
+            }
+          out[slot] = &*entry;
+        }
+      return count;
+    }
+
     // Prints the beacon Address and Information to the output stream
     void
     DistanceTable::Print (Ptr<OutputStreamWrapper> os) const
     {
-      *os->GetStream () << m_table.size () << " entries\n";
-      for(std::map<Ipv4Address,BeaconInfo>::const_iterator j = m_table.begin (); j != m_table.end (); ++j)
+      // In address order, as when the table was a map, so dumps do not depend on arrival order
+      std::vector<const BeaconInfo*> sorted;
+      sorted.reserve (m_entries.size ());
+      for(Iterator j = m_entries.begin (); j != m_entries.end (); ++j)
+        {
+          sorted.push_back (&*j);
+        }
+      std::sort (sorted.begin (), sorted.end (), CompareAddress);
+
+      *os->GetStream () << m_entries.size () << " entries\n";
+      for(std::vector<const BeaconInfo*>::const_iterator j = sorted.begin (); j != sorted.end (); ++j)
         {
           //                    BeaconAddr           BeaconInfo
-          *os->GetStream () <<  j->first << "\t" << j->second;
+          *os->GetStream () <<  (*j)->GetAddress () << "\t" << **j;
         }
     }
 
@@ -1,8 +1,8 @@
 #ifndef DISTANCETABLE_H
 #define DISTANCETABLE_H
 
-#include <map>
 #include <vector>
+#include <unordered_map>
 #include "ns3/ipv4.h"
 #include "ns3/nstime.h"
 #include "ns3/output-stream-wrapper.h"
@@ -15,20 +15,41 @@ namespace ns3
 
     typedef std::pair<double, double> Position;
 
+    /**
+     * @brief IsNewerSequenceNumber Serial number comparison (RFC 1982) that survives wraparound
+     * @return True if a was issued after b
+     */
+    inline bool IsNewerSequenceNumber (uint16_t a, uint16_t b)
+    {
+      return (int16_t)(uint16_t)(a - b) > 0;
+    }
+
     // Class object to locally store beacon information
     class BeaconInfo
     {
     public:
+      BeaconInfo() : m_hops (0), m_pos (-1.0, -1.0), m_hopSize (-1.0), m_dirty (false), m_seqNo (0) {}
+
+      Ipv4Address GetAddress() const  { return m_address;  }
       uint16_t  GetHops()     const   { return m_hops;     }  
-      Position  GetPosition() const   { return m_pos;      }
+      const Position& GetPosition() const { return m_pos; }
       Time      GetTime()     const   { return m_updatedAt;}
       double    GetHopSize()     const   { return m_hopSize;}
+      bool      IsDirty()     const   { return m_dirty;    }
+      uint16_t  GetSequenceNumber() const { return m_seqNo; }
+      Time      GetRefreshTime() const  { return m_refreshedAt; }
+      void SetAddress (Ipv4Address a) { m_address = a;  }
       void SetHops    (uint16_t hops) { m_hops = hops;  }
       void SetPosition(Position p)    { m_pos  = p;     }
       void SetTime    ( Time t )      { m_updatedAt = t;}
       void SetHopSize    ( double hopSize )      { m_hopSize = hopSize;}
+      void SetDirty   (bool dirty)    { m_dirty = dirty; }
+      void SetSequenceNumber (uint16_t seqNo) { m_seqNo = seqNo; }
+      void SetRefreshTime (Time t)    { m_refreshedAt = t; }
 
     private:
+      // The beacon address
+      Ipv4Address m_address;
       // # of hops to beacon
       uint16_t m_hops;
       // The beacons coordinates (as a pair)
@@ -37,6 +58,12 @@ namespace ns3
       Time     m_updatedAt;
       // Hop Size
       double m_hopSize;
+      // Changed since the last advertisement
+      bool     m_dirty;
+      // Latest beacon sequence number that confirmed the hop count
+      uint16_t m_seqNo;
+      // Time of that confirmation
+      Time     m_refreshedAt;
     };
 
     std::ostream & operator<< (std::ostream & os, BeaconInfo const &);
@@ -47,17 +74,49 @@ namespace ns3
     /**
      * @brief The DistanceTable class stores local
      *information about the beacons known to the node.
+     *
+     * Entries are kept contiguously, one slot per beacon in discovery order.
+     * A slot index never changes once assigned, so callers may cache it.
      */
     class DistanceTable
     {
     public:
+      typedef std::vector<BeaconInfo>::const_iterator Iterator;
+
       DistanceTable();
 
       /**
        * @brief GetSize The number of entries stored in this table
        * @return The size
        */
-      size_t  GetSize() const  { return m_table.size (); }
+      size_t  GetSize() const  { return m_entries.size (); }
+
+      /**
+       * @brief Begin/End Iterate over every entry without copying it
+       */
+      Iterator Begin() const   { return m_entries.begin (); }
+      Iterator End() const     { return m_entries.end (); }
+
+      /**
+       * @brief GetEntry Gets the entry stored in a slot
+       * @param index The slot, lower than GetSize ()
+       * @return The entry
+       */
+      const BeaconInfo& GetEntry(uint32_t index) const  { return m_entries[index]; }
+
+      /**
+       * @brief Find Looks up the entry of a beacon with a single lookup
+       * @param beacon The beacon address
+       * @return The entry, or 0 if the beacon is unknown
+       */
+      const BeaconInfo* Find(Ipv4Address beacon) const;
+
+      /**
+       * @brief GetIndexOf Gets the slot of a beacon
+       * @param beacon The beacon address
+       * @return The slot index, or -1 if the beacon is unknown
+       */
+      int32_t GetIndexOf(Ipv4Address beacon) const;
 
 
       /**
@@ -67,6 +126,18 @@ namespace ns3
        */
       uint16_t    GetHopsTo(Ipv4Address beacon) const;
 
+      /**
+       * @brief AcceptsPath Whether an advertised path may set the hop count, as in DSDV:
+       * a shorter path of the same round, or a path of a newer round that is not
+       * longer, unless the entry was not confirmed within staleTimeout
+       * @param beacon The beacon address
+       * @param hops The advertised hop count, this node's hop included
+       * @param seqNo The advertised beacon sequence number
+       * @param staleTimeout Time after which an unconfirmed entry accepts a longer path
+       * @return True for an unknown beacon, false for an older sequence number
+       */
+      bool AcceptsPath(Ipv4Address beacon, uint16_t hops, uint16_t seqNo, Time staleTimeout) const;
+
 
       /**
        * @brief GetHopSizeOf Gets the last known hops to a certain beacon
@@ -90,11 +161,41 @@ namespace ns3
       Time LastUpdatedAt(Ipv4Address beacon) const;
 
       /**
-       * @brief GetKnownBeacons
+       * @brief GetKnownBeacons Prefer Begin/End on hot paths, this allocates a vector
        * @return A vector containing the known beacons
        */
       std::vector<Ipv4Address> GetKnownBeacons() const;
 
+      /**
+       * @brief SelectLowestAddresses Gets the entries with a known hop size and the
+       * lowest beacon addresses, the first ones of the table when it was kept in
+       * address order, whatever order the beacons were discovered in
+       * @param out Receives up to n entries, in address order
+       * @param n The number of entries wanted
+       * @return The number of entries stored in out
+       */
+      uint32_t SelectLowestAddresses(const BeaconInfo **out, uint32_t n) const;
+
+      /**
+       * @brief Refresh Records that the beacon confirmed the current hop count,
+       * marking the entry dirty if the sequence number changed
+       * @param beacon The beacon address
+       * @param seqNo The beacon sequence number of the confirmation
+       */
+      void Refresh(Ipv4Address beacon, uint16_t seqNo);
+
+      /**
+       * @brief IsDirty Whether the entry changed since the last call to ClearDirty
+       * @param beacon The beacon address
+       * @return True if the entry is new or its hops or hop size changed
+       */
+      bool IsDirty(Ipv4Address beacon) const;
+
+      /**
+       * @brief ClearDirty Marks every entry as advertised
+       */
+      void ClearDirty();
+
       /**
        * @brief Print Print this DistanceTable to the output stream provided
        * @param os The stream
@@ -102,16 +203,21 @@ namespace ns3
       void Print(Ptr<OutputStreamWrapper> os) const;
 
       /**
-       * @brief AddBeacon Creates or updates an entry for a newly discovered beacon
+       * @brief AddBeacon Creates or updates an entry for a newly discovered beacon.
+       * The entry is marked dirty when it is new or its hops or hop size change.
        * @param beacon The beacon address
        * @param hops Hops to the beacon
        * @param xPos X coordinate
        * @param yPos Y coordinate
+       * @return The slot index of the entry
        */
-      void AddBeacon(Ipv4Address beacon, uint16_t hops, double hopSize, double xPos, double yPos);
+      uint32_t AddBeacon(Ipv4Address beacon, uint16_t hops, double hopSize, double xPos, double yPos);
 
     private:
-      std::map<Ipv4Address, BeaconInfo>  m_table;
+      // One slot per beacon, in discovery order
+      std::vector<BeaconInfo>  m_entries;
+      // Beacon address -> slot
+      std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>  m_index;
     };
 
   }
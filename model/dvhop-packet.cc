@@ -1,6 +1,10 @@
 #include "dvhop-packet.h"
+#include "dvhop-profiler.h"
 #include "ns3/packet.h"
 #include "ns3/address-utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3
 {
@@ -124,6 +128,316 @@ namespace ns3
     }
 
 
+    // LEB128 helpers for the hop counts and sequence numbers of the compact format
+    static void
+    WriteVarint (Buffer::Iterator &i, uint32_t value)
+    {
+      while (value >= 0x80)
+        {
+          i.WriteU8 ((value & 0x7f) | 0x80);
+          value >>= 7;
+        }
+      i.WriteU8 (value);
+    }
+
+    static uint32_t
+    ReadVarint (Buffer::Iterator &i)
+    {
+      uint32_t value = 0;
+      uint8_t shift = 0;
+      uint8_t byte;
+      do
+        {
+          byte = i.ReadU8 ();
+          value |= (uint32_t)(byte & 0x7f) << shift;
+          shift += 7;
+        }
+      while ((byte & 0x80) && shift < 32);
+      return value;
+    }
+
+    static uint32_t
+    GetVarintSize (uint32_t value)
+    {
+      uint32_t size = 1;
+      while (value >= 0x80)
+        {
+          value >>= 7;
+          size++;
+        }
+      return size;
+    }
+
+    // Fixed point values are written big endian on as many bytes as needed
+    static void
+    WriteFixed (Buffer::Iterator &i, uint32_t value, uint8_t bytes)
+    {
+      for (int8_t b = bytes - 1; b >= 0; --b)
+        {
+          i.WriteU8 ((value >> (8 * b)) & 0xff);
+        }
+    }
+
+    static uint32_t
+    ReadFixed (Buffer::Iterator &i, uint8_t bytes)
+    {
+      uint32_t value = 0;
+      for (uint8_t b = 0; b < bytes; ++b)
+        {
+          value = (value << 8) | i.ReadU8 ();
+        }
+      return value;
+    }
+
+    // Hop size value of an entry without a known hop size
+    static const uint16_t UNKNOWN_HOP_SIZE = 0xffff;
+
+
+    NS_OBJECT_ENSURE_REGISTERED (FloodingBatchHeader);
+
+    FloodingBatchHeader::FloodingBatchHeader() :  // Default Constructor
+      m_format (FULL_FORMAT),
+      m_helloCounter (0),
+      m_coordBits (24),
+      m_resolution (10),
+      m_base (0)
+    {
+    }
+
+    TypeId
+    FloodingBatchHeader::GetTypeId ()
+    {
+      static TypeId tid = TypeId("ns3::dvhop::FloodingBatchHeader")
+          .SetParent<Header> ()
+          .AddConstructor<FloodingBatchHeader>();
+      return tid;
+    }
+
+    TypeId
+    FloodingBatchHeader::GetInstanceTypeId () const
+    {
+      return GetTypeId ();
+    }
+
+    void
+    FloodingBatchHeader::SetCompact (uint8_t coordBits, double resolution)
+    {
+      NS_ASSERT (coordBits >= 8 && coordBits <= 32);
+      NS_ASSERT (resolution >= 0.001 && resolution <= 65.535);
+      m_format = COMPACT_FORMAT;
+      m_coordBits = coordBits;
+      m_resolution = std::floor (resolution * 1000 + 0.5);
+    }
+
+    bool
+    FloodingBatchHeader::CanAdd (const FloodingHeader &entry) const
+    {
+      return m_format == FULL_FORMAT || m_entries.empty ()
+             || (entry.GetBeaconAddress ().Get () & 0xffff0000) == m_base;
+    }
+
+    void
+    FloodingBatchHeader::AddEntry (const FloodingHeader &entry)
+    {
+      NS_ASSERT (CanAdd (entry));
+      if (m_entries.empty ())
+        {
+          m_base = entry.GetBeaconAddress ().Get () & 0xffff0000;
+        }
+      m_entries.push_back (entry);
+    }
+
+    uint32_t
+    FloodingBatchHeader::GetHeaderSize () const
+    {
+      // Version, HELLO counter and entry count, plus the compact parameters
+      return m_format == FULL_FORMAT ? 1 + 2 + 2 : 1 + 2 + 1 + 2 + 4 + 4 + 4 + 2;
+    }
+
+    uint32_t
+    FloodingBatchHeader::GetEntrySize (const FloodingHeader &entry) const
+    {
+      if (m_format == FULL_FORMAT)
+        {
+          return entry.GetSerializedSize ();
+        }
+      return 2 + 2 * ((m_coordBits + 7) / 8) + 2
+             + GetVarintSize (entry.GetHopCount ()) + GetVarintSize (entry.GetSequenceNumber ());
+    }
+
+    uint32_t
+    FloodingBatchHeader::GetMaxEntrySize () const
+    {
+      if (m_format == FULL_FORMAT)
+        {
+          return FloodingHeader ().GetSerializedSize ();
+        }
+      return 2 + 2 * ((m_coordBits + 7) / 8) + 2 + 2 * GetVarintSize (0xffff);
+    }
+
+    uint32_t
+    FloodingBatchHeader::GetSerializedSize () const
+    {
+      uint32_t size = GetHeaderSize ();
+      for (std::vector<FloodingHeader>::const_iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+        {
+          size += GetEntrySize (*it);
+        }
+      return size;
+    }
+
+    uint16_t
+    FloodingBatchHeader::GetMaxEntries (uint32_t payloadSize) const
+    {
+      uint32_t entrySize = GetMaxEntrySize ();
+      if (payloadSize < GetHeaderSize () + entrySize)
+        {
+          return 1;
+        }
+      return std::min<uint32_t> ((payloadSize - GetHeaderSize ()) / entrySize, 0xffff);
+    }
+
+    uint32_t
+    FloodingBatchHeader::Quantize (double value, int32_t origin, uint32_t max) const
+    {
+      double steps = std::floor (value * 1000 / m_resolution + 0.5) - origin;
+      if (steps <= 0)
+        {
+          return 0;
+        }
+      return steps >= max ? max : (uint32_t) steps;
+    }
+
+    int32_t
+    FloodingBatchHeader::GetOrigin (bool y) const
+    {
+      if (m_entries.empty ())
+        {
+          return 0;
+        }
+      double min = std::numeric_limits<double>::max ();
+      for (std::vector<FloodingHeader>::const_iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+        {
+          min = std::min (min, y ? it->GetYPosition () : it->GetXPosition ());
+        }
+      double steps = std::floor (min * 1000 / m_resolution + 0.5);
+      return std::max<double> (std::min<double> (steps, std::numeric_limits<int32_t>::max ()),
+                               std::numeric_limits<int32_t>::min ());
+    }
+
+    void
+    FloodingBatchHeader::Serialize (Buffer::Iterator start) const
+    {
+      DVHOP_PROFILE_SCOPE ("FloodingBatchHeader::Serialize");
+      start.WriteU8 (m_format);
+      start.WriteHtonU16 (m_helloCounter);
+      if (m_format == FULL_FORMAT)
+        {
+          start.WriteHtonU16 (m_entries.size ());
+          for (std::vector<FloodingHeader>::const_iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+            {
+              it->Serialize (start);
+              start.Next (it->GetSerializedSize ());
+            }
+          return;
+        }
+
+      uint8_t coordBytes = (m_coordBits + 7) / 8;
+      uint32_t maxCoord = (uint32_t)((((uint64_t) 1) << m_coordBits) - 1);
+      int32_t originX = GetOrigin (false);
+      int32_t originY = GetOrigin (true);
+      start.WriteU8 (m_coordBits);
+      start.WriteHtonU16 (m_resolution);
+      start.WriteHtonU32 (m_base);
+      start.WriteHtonU32 ((uint32_t) originX);
+      start.WriteHtonU32 ((uint32_t) originY);
+      start.WriteHtonU16 (m_entries.size ());
+      for (std::vector<FloodingHeader>::const_iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+        {
+          start.WriteHtonU16 (it->GetBeaconAddress ().Get () & 0xffff);
+          WriteFixed (start, Quantize (it->GetXPosition (), originX, maxCoord), coordBytes);
+          WriteFixed (start, Quantize (it->GetYPosition (), originY, maxCoord), coordBytes);
+          start.WriteHtonU16 (it->GetHopSize () < 0 ? UNKNOWN_HOP_SIZE : Quantize (it->GetHopSize (), 0, UNKNOWN_HOP_SIZE - 1));
+          WriteVarint (start, it->GetHopCount ());
+          WriteVarint (start, it->GetSequenceNumber ());
+        }
+    }
+
+    uint32_t
+    FloodingBatchHeader::Deserialize (Buffer::Iterator start)
+    {
+      DVHOP_PROFILE_SCOPE ("FloodingBatchHeader::Deserialize");
+      Buffer::Iterator i = start;
+
+      uint8_t version = i.ReadU8 ();
+      m_entries.clear ();
+      if (version != FULL_FORMAT && version != COMPACT_FORMAT)
+        {
+          return 0; // Unknown version, nothing can be read
+        }
+      m_format = (WireFormat) version;
+      m_helloCounter = i.ReadNtohU16 ();
+      if (m_format == FULL_FORMAT)
+        {
+          uint16_t count = i.ReadNtohU16 ();
+          m_entries.resize (count);
+          for (uint16_t k = 0; k < count; ++k)
+            {
+              i.Next (m_entries[k].Deserialize (i));
+            }
+        }
+      else
+        {
+          m_coordBits = i.ReadU8 ();
+          m_resolution = i.ReadNtohU16 ();
+          m_base = i.ReadNtohU32 ();
+          int32_t originX = (int32_t) i.ReadNtohU32 ();
+          int32_t originY = (int32_t) i.ReadNtohU32 ();
+          uint16_t count = i.ReadNtohU16 ();
+          if (m_coordBits < 8 || m_coordBits > 32 || m_resolution == 0)
+            {
+              return 0;
+            }
+
+          uint8_t coordBytes = (m_coordBits + 7) / 8;
+          double step = m_resolution / 1000.0;
+          m_entries.reserve (count);
+          for (uint16_t k = 0; k < count; ++k)
+            {
+              Ipv4Address beacon (m_base | i.ReadNtohU16 ());
+              double x = ((double) originX + ReadFixed (i, coordBytes)) * step;
+              double y = ((double) originY + ReadFixed (i, coordBytes)) * step;
+              uint16_t hopSize = i.ReadNtohU16 ();
+              uint16_t hops = ReadVarint (i);
+              uint16_t seqNo = ReadVarint (i);
+              m_entries.push_back (FloodingHeader (x, y, seqNo, hops, hopSize == UNKNOWN_HOP_SIZE ? -1.0 : hopSize * step, beacon));
+            }
+        }
+
+      uint32_t dist = i.GetDistanceFrom (start);
+      NS_ASSERT (dist == GetSerializedSize () );
+      return dist;
+    }
+
+    // Prints every entry carried in the batch
+    void
+    FloodingBatchHeader::Print (std::ostream &os) const
+    {
+      os << "Version: " << (uint32_t) m_format << " ,HELLO: " << m_helloCounter << " ,Entries: " << m_entries.size ();
+      for (std::vector<FloodingHeader>::const_iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+        {
+          it->Print (os);
+        }
+    }
+
+    std::ostream &
+    operator<< (std::ostream &os, FloodingBatchHeader const &h)
+    {
+      h.Print (os);
+      return os;
+    }
+
+
 
   }
 }
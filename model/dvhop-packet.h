@@ -2,6 +2,7 @@
 #define DVHOP_PACKET_H
 
 #include <iostream>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/enum.h"
 #include "ns3/ipv4-address.h"
@@ -58,12 +59,12 @@ namespace ns3
       void SetSequenceNumber(uint16_t sn)  { m_seqNo = sn;   }
       void SetBeaconAddress(Ipv4Address a) { m_beaconId = a; }
 
-      double    GetXPosition()        {   return m_xPos;     }
-      double    GetYPosition()        {   return m_yPos;     }
-      uint16_t GetHopCount()         {   return m_hopCount; }
-      double    GetHopSize()        {   return m_hopSize;     }
-      uint16_t GetSequenceNumber()   {   return m_seqNo;    }
-      Ipv4Address GetBeaconAddress() {   return m_beaconId; }
+      double    GetXPosition()       const {   return m_xPos;     }
+      double    GetYPosition()       const {   return m_yPos;     }
+      uint16_t GetHopCount()         const {   return m_hopCount; }
+      double    GetHopSize()         const {   return m_hopSize;     }
+      uint16_t GetSequenceNumber()   const {   return m_seqNo;    }
+      Ipv4Address GetBeaconAddress() const {   return m_beaconId; }
 
 
     private:
@@ -78,6 +79,128 @@ namespace ns3
     std::ostream & operator<< (std::ostream & os, FloodingHeader const &);
 
 
+    // Encoding of the entries in a FloodingBatchHeader, also its version number
+    enum WireFormat
+    {
+      FULL_FORMAT = 1,     // Every entry is a 32 byte FloodingHeader
+      COMPACT_FORMAT = 2   // Fixed point coordinates, 16 bit beacon index, varint hops
+    };
+
+    /*
+    Full format (version 1)
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |    Version    |        HELLO counter          |  Entry count  |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |  (continued)  |                                               |
+    +-+-+-+-+-+-+-+-+                                               +
+    |               Entry count x FloodingHeader (32 bytes)         |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+    Compact format (version 2)
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |    Version    |        HELLO counter          |  Coord. bits  |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |       Resolution (mm)         |  Base address (lower 16 bits  |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |        are zero)              |  Origin X (signed, in         |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |   Resolution units)           |  Origin Y (signed, in         |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |   Resolution units)           |         Entry count           |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |         Entries ...                                           |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+    HELLO counter: incremented by the sender for every HELLO packet, so
+    receivers can count the packets they missed
+
+    Origin: the smallest coordinates of the batch, entries are encoded
+    above it so negative positions survive
+
+    Compact entry: beacon index (16, base + index = beacon address),
+    X and Y (Coord. bits each, in Resolution units above the origin), hop size (16, in
+    Resolution units, 0xffff if unknown), hops (varint), sequence number (varint)
+    */
+    /**
+     * @brief The FloodingBatchHeader class carries several flooded beacon
+     * entries in a single HELLO packet, so a node advertises its whole
+     * DistanceTable with a handful of packets instead of one per beacon.
+     *
+     * The compact format clamps coordinates to (2^bits - 1) * resolution above
+     * the smallest ones of the batch, and a batch only holds beacons that share
+     * the upper 16 address bits. Deserialize returns 0 for an unknown version.
+     */
+    class FloodingBatchHeader: public Header
+    {
+    public:
+
+      FloodingBatchHeader();
+
+      //Serializing and deserializing
+      //{
+      static TypeId    GetTypeId (void);
+      TypeId           GetInstanceTypeId () const;
+      virtual void     Serialize (Buffer::Iterator start) const;
+      virtual uint32_t Deserialize (Buffer::Iterator start);
+      virtual uint32_t GetSerializedSize () const;
+      virtual void     Print (std::ostream &os) const;
+      //}
+
+      /**
+       * @brief SetCompact Selects the compact format for serialization
+       * @param coordBits Bits per coordinate, between 8 and 32
+       * @param resolution Size of a coordinate step in meters, between 1 mm and 65.535 m
+       */
+      void SetCompact(uint8_t coordBits, double resolution);
+      WireFormat GetFormat() const                        { return m_format; }
+
+      /**
+       * @brief CanAdd Whether the entry can be encoded in this batch
+       * @param entry The entry
+       * @return False if the compact format cannot index the beacon from this batch's base address
+       */
+      bool CanAdd(const FloodingHeader &entry) const;
+      void AddEntry(const FloodingHeader &entry);
+      void Clear()                                 { m_entries.clear (); }
+
+      void     SetHelloCounter(uint16_t counter)          { m_helloCounter = counter; }
+      uint16_t GetHelloCounter() const                    { return m_helloCounter; }
+
+      uint16_t              GetNEntries() const           { return m_entries.size (); }
+      const FloodingHeader& GetEntry(uint16_t i) const    { return m_entries[i]; }
+
+      /**
+       * @brief GetMaxEntries The number of entries that always fit in a batch of this format
+       * @param payloadSize Bytes available for the header (e.g. MTU minus IP and UDP headers)
+       * @return The maximum number of entries, at least 1
+       */
+      uint16_t GetMaxEntries(uint32_t payloadSize) const;
+
+    private:
+      uint32_t GetHeaderSize() const;
+      uint32_t GetEntrySize(const FloodingHeader &entry) const;
+      uint32_t GetMaxEntrySize() const;
+      uint32_t Quantize(double value, int32_t origin, uint32_t max) const;
+      // Smallest coordinate of the entries, in resolution units
+      int32_t  GetOrigin(bool y) const;
+
+      WireFormat  m_format;
+      uint16_t    m_helloCounter;
+      // Compact format only
+      uint8_t     m_coordBits;
+      uint16_t    m_resolution;   // mm
+      uint32_t    m_base;         // Upper 16 bits of every beacon address
+
+      std::vector<FloodingHeader> m_entries;
+    };
+
+    std::ostream & operator<< (std::ostream & os, FloodingBatchHeader const &);
+
+
   }
 }
 
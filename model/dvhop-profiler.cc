@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "dvhop-profiler.h"
+
+#ifdef DVHOP_ENABLE_PROFILING
+
+#include "ns3/simulator.h"
+#include <cstring>
+#include <deque>
+#include <iostream>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    bool Profiler::s_dumpScheduled = false;
+
+    // Every site of the process, a deque keeps the returned pointers valid
+    static std::deque<ProfileSite>&
+    GetSites ()
+    {
+      static std::deque<ProfileSite> sites;
+      return sites;
+    }
+
+    // Upper bound of the bucket holding the p-th call
+    static uint64_t
+    Percentile (const ProfileSite &site, double p)
+    {
+      uint64_t rank = site.calls * p;
+      uint64_t count = 0;
+      for (uint32_t b = 0; b < ProfileSite::N_BUCKETS; ++b)
+        {
+          count += site.buckets[b];
+          if (count > rank)
+            {
+              return ((uint64_t) 2) << b;
+            }
+        }
+      return ((uint64_t) 2) << (ProfileSite::N_BUCKETS - 1);
+    }
+
+    ProfileSite*
+    Profiler::Register (const char *name)
+    {
+      ProfileSite site;
+      std::memset (&site, 0, sizeof (site));
+      site.name = name;
+      GetSites ().push_back (site);
+      return &GetSites ().back ();
+    }
+
+    void
+    Profiler::Dump (std::ostream &os)
+    {
+      std::deque<ProfileSite> &sites = GetSites ();
+      os << "DV-Hop profile, wall time per call (percentiles are bucket upper bounds)\n"
+         << "scope,calls,total_ms,mean_ns,p50_ns,p90_ns,p99_ns\n";
+      for (std::deque<ProfileSite>::const_iterator it = sites.begin (); it != sites.end (); ++it)
+        {
+          if (it->calls == 0)
+            continue;
+          os << it->name << "," << it->calls << "," << it->totalNs / 1e6 << "," << it->totalNs / it->calls << ","
+             << Percentile (*it, 0.5) << "," << Percentile (*it, 0.9) << "," << Percentile (*it, 0.99) << "\n";
+        }
+      os << "scope,bucket_from_ns,bucket_to_ns,calls\n";
+      for (std::deque<ProfileSite>::const_iterator it = sites.begin (); it != sites.end (); ++it)
+        {
+          for (uint32_t b = 0; b < ProfileSite::N_BUCKETS; ++b)
+            {
+              if (it->buckets[b] > 0)
+                os << it->name << "," << (b == 0 ? 0 : ((uint64_t) 1) << b) << "," << (((uint64_t) 2) << b)
+                   << "," << it->buckets[b] << "\n";
+            }
+        }
+      os.flush ();
+    }
+
+    void
+    Profiler::Reset ()
+    {
+      std::deque<ProfileSite> &sites = GetSites ();
+      for (std::deque<ProfileSite>::iterator it = sites.begin (); it != sites.end (); ++it)
+        {
+          it->calls = 0;
+          it->totalNs = 0;
+          std::memset (it->buckets, 0, sizeof (it->buckets));
+        }
+    }
+
+    void
+    Profiler::ScheduleDumpAtDestroy ()
+    {
+      s_dumpScheduled = true;
+      Simulator::ScheduleDestroy (&Profiler::DumpAtDestroy);
+    }
+
+    void
+    Profiler::DumpAtDestroy ()
+    {
+      Dump (std::clog);
+      Reset ();
+      s_dumpScheduled = false;
+    }
+
+  }
+}
+
+#endif /* DVHOP_ENABLE_PROFILING */
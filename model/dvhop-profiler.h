@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DVHOP_PROFILER_H
+#define DVHOP_PROFILER_H
+
+/*
+    Hot path timing for the DV-Hop module.
+
+    DVHOP_PROFILE_SCOPE ("Name") at the top of a block counts the calls and
+    the wall time spent in the block, in a histogram of power of two
+    nanosecond buckets shared by the whole process. The tables are printed
+    to std::clog at Simulator::Destroy, then cleared for the next run.
+
+    The macro expands to nothing unless the module is built with
+      ./waf configure --enable-dvhop-profiling
+    which defines DVHOP_ENABLE_PROFILING. The counters are not atomic, only
+    the simulation thread may enter profiled scopes.
+*/
+
+#ifdef DVHOP_ENABLE_PROFILING
+
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    // Calls and wall time of one profiled scope
+    struct ProfileSite
+    {
+      static const uint32_t N_BUCKETS = 40;   // Bucket b holds [2^b, 2^(b+1)) ns, the last one up to ~18 min
+
+      const char *name;
+      uint64_t    calls;
+      uint64_t    totalNs;
+      uint64_t    buckets[N_BUCKETS];
+
+      void Record (uint64_t ns)
+      {
+        uint32_t bucket = 0;
+        while (ns >> (bucket + 1) && bucket + 1 < N_BUCKETS)
+          {
+            bucket++;
+          }
+        calls++;
+        totalNs += ns;
+        buckets[bucket]++;
+      }
+    };
+
+    class Profiler
+    {
+    public:
+      /**
+       * @brief Register Adds a profiled scope, once per call site
+       * @param name Name printed in the tables, must outlive the process
+       * @return The site, owned by the profiler
+       */
+      static ProfileSite* Register (const char *name);
+
+      /**
+       * @brief Dump Prints one row per scope with calls, total and percentile
+       * times, then the non-empty histogram buckets
+       * @param os The stream
+       */
+      static void Dump (std::ostream &os);
+
+      /**
+       * @brief Reset Clears the counters of every scope
+       */
+      static void Reset ();
+
+      // Makes sure the tables are dumped at the end of the current simulation
+      static void ScheduleDump ()
+      {
+        if (!s_dumpScheduled)
+          {
+            ScheduleDumpAtDestroy ();
+          }
+      }
+
+    private:
+      static void ScheduleDumpAtDestroy ();
+      static void DumpAtDestroy ();
+      static bool s_dumpScheduled;
+    };
+
+    // Times its own lifetime into a site
+    class ProfileScope
+    {
+    public:
+      explicit ProfileScope (ProfileSite *site)
+        : m_site (site), m_start (std::chrono::steady_clock::now ())
+      {
+        Profiler::ScheduleDump ();
+      }
+      ~ProfileScope ()
+      {
+        m_site->Record (std::chrono::duration_cast<std::chrono::nanoseconds> (
+                          std::chrono::steady_clock::now () - m_start).count ());
+      }
+
+    private:
+      ProfileSite *m_site;
+      std::chrono::steady_clock::time_point m_start;
+    };
+
+  }
+}
+
+#define DVHOP_PROFILE_CONCAT2(a, b) a ## b
+#define DVHOP_PROFILE_CONCAT(a, b) DVHOP_PROFILE_CONCAT2 (a, b)
+#define DVHOP_PROFILE_SCOPE(name)                                                                    \
+  static ::ns3::dvhop::ProfileSite *DVHOP_PROFILE_CONCAT (dvhopProfileSite, __LINE__) =              \
+    ::ns3::dvhop::Profiler::Register (name);                                                         \
+  ::ns3::dvhop::ProfileScope DVHOP_PROFILE_CONCAT (dvhopProfileScope, __LINE__) (DVHOP_PROFILE_CONCAT (dvhopProfileSite, __LINE__))
+
+#else
+
+#define DVHOP_PROFILE_SCOPE(name)
+
+#endif /* DVHOP_ENABLE_PROFILING */
+
+#endif /* DVHOP_PROFILER_H */
@@ -2,8 +2,13 @@
 
 #include "dvhop.h"
 #include "dvhop-packet.h"
+#include "dvhop-profiler.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
@@ -13,6 +18,7 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/node-list.h"
+#include <cmath>
 
 
 
@@ -36,17 +42,186 @@ namespace ns3 {
                          TimeValue (Seconds (1)),                              // default value
                          MakeTimeAccessor (&RoutingProtocol::HelloInterval),   // accessed through
                          MakeTimeChecker ())
+          .AddAttribute ("TriggeredUpdates",
+                         "Advertise only the entries that changed since the last HELLO, with a periodic full refresh.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&RoutingProtocol::m_triggeredUpdates),
+                         MakeBooleanChecker ())
+          .AddAttribute ("FullRefreshInterval",
+                         "Interval between full table advertisements when TriggeredUpdates is enabled.",
+                         TimeValue (Seconds (10)),
+                         MakeTimeAccessor (&RoutingProtocol::m_fullRefreshInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("PositionSolver",
+                         "Estimator used by regular nodes to compute their position.",
+                         EnumValue (TRILATERATION),
+                         MakeEnumAccessor (&RoutingProtocol::m_solver),
+                         MakeEnumChecker (TRILATERATION, "Trilateration",
+                                          LEAST_SQUARES, "LeastSquares"))
+          .AddAttribute ("PositionUpdateInterval",
+                         "Minimum time between two position estimates, 0 to estimate on every table change.",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&RoutingProtocol::m_positionUpdateInterval),
+                         MakeTimeChecker ())
+          .AddAttribute ("WireFormat",
+                         "Encoding of the HELLO entries.",
+                         EnumValue (FULL_FORMAT),
+                         MakeEnumAccessor (&RoutingProtocol::m_wireFormat),
+                         MakeEnumChecker (FULL_FORMAT, "Full",
+                                          COMPACT_FORMAT, "Compact"))
+          .AddAttribute ("CoordinateBits",
+                         "Bits per coordinate in the compact wire format.",
+                         UintegerValue (24),
+                         MakeUintegerAccessor (&RoutingProtocol::m_coordinateBits),
+                         MakeUintegerChecker<uint8_t> (8, 32))
+          .AddAttribute ("CoordinateResolution",
+                         "Coordinate and hop size step in meters in the compact wire format.",
+                         DoubleValue (0.01),
+                         MakeDoubleAccessor (&RoutingProtocol::m_coordinateResolution),
+                         MakeDoubleChecker<double> (0.001, 65.535))
+          .AddAttribute ("StaleEntryTimeout",
+                         "Time without confirmation after which a fresher but longer path replaces an entry. "
+                         "Must be longer than FullRefreshInterval when TriggeredUpdates is enabled.",
+                         TimeValue (Seconds (3)),
+                         MakeTimeAccessor (&RoutingProtocol::m_staleEntryTimeout),
+                         MakeTimeChecker ())
+          .AddAttribute ("HelloTimerMode",
+                         "Scheduling of HELLO messages.",
+                         EnumValue (FIXED_TIMER),
+                         MakeEnumAccessor (&RoutingProtocol::m_helloTimerMode),
+                         MakeEnumChecker (FIXED_TIMER, "Fixed",
+                                          TRICKLE_TIMER, "Trickle"))
+          .AddAttribute ("TrickleImin",
+                         "Minimum Trickle interval, used after every inconsistency.",
+                         TimeValue (Seconds (1)),
+                         MakeTimeAccessor (&RoutingProtocol::m_trickleImin),
+                         MakeTimeChecker (MilliSeconds (1)))
+          .AddAttribute ("TrickleImax",
+                         "Maximum Trickle interval.",
+                         TimeValue (Seconds (64)),
+                         MakeTimeAccessor (&RoutingProtocol::m_trickleImax),
+                         MakeTimeChecker (MilliSeconds (1)))
+          .AddAttribute ("TrickleK",
+                         "Redundancy constant: a HELLO is suppressed after this many consistent advertisements in the interval.",
+                         UintegerValue (2),
+                         MakeUintegerAccessor (&RoutingProtocol::m_trickleK),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("PositionEpsilon",
+                         "Distance in meters a new estimate must move to count as a change.",
+                         DoubleValue (0.01),
+                         MakeDoubleAccessor (&RoutingProtocol::m_positionEpsilon),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("FieldWidth",
+                         "Width of the simulation area in meters, estimates are clamped to [0, FieldWidth].",
+                         DoubleValue (100),
+                         MakeDoubleAccessor (&RoutingProtocol::m_fieldWidth),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("FieldHeight",
+                         "Height of the simulation area in meters, estimates are clamped to [0, FieldHeight].",
+                         DoubleValue (100),
+                         MakeDoubleAccessor (&RoutingProtocol::m_fieldHeight),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("TxPacing",
+                         "Gap between two HELLO packets of the same round, 0 to send them back-to-back.",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&RoutingProtocol::m_txPacing),
+                         MakeTimeChecker ())
+          .AddAttribute ("RandomStartPhase",
+                         "Send the first HELLO at a random point of the first HelloInterval instead of all nodes at once.",
+                         BooleanValue (true),
+                         MakeBooleanAccessor (&RoutingProtocol::m_randomStartPhase),
+                         MakeBooleanChecker ())
+          .AddAttribute ("MaxJitter",
+                         "Jitter window per queued HELLO packet, widened with the neighbour density and capped at HelloInterval/2.",
+                         TimeValue (MilliSeconds (10)),
+                         MakeTimeAccessor (&RoutingProtocol::m_maxJitter),
+                         MakeTimeChecker ())
+          .AddAttribute ("JitterNeighborReference",
+                         "Neighbour count above which the jitter window grows proportionally.",
+                         UintegerValue (10),
+                         MakeUintegerAccessor (&RoutingProtocol::m_jitterNeighborReference),
+                         MakeUintegerChecker<uint32_t> (1))
+          .AddAttribute ("SplitHorizon",
+                         "Leave out of the HELLOs the entries that every neighbour already holds at an equal or shorter hop count.",
+                         BooleanValue (false),
+                         MakeBooleanAccessor (&RoutingProtocol::m_splitHorizon),
+                         MakeBooleanChecker ())
+          .AddAttribute ("NeighborTimeout",
+                         "Time after which a silent neighbour is forgotten. Longer than two FullRefreshIntervals, "
+                         "since with split horizon a node may only send the periodic full refresh.",
+                         TimeValue (Seconds (25)),
+                         MakeTimeAccessor (&RoutingProtocol::m_neighborTimeout),
+                         MakeTimeChecker ())
           .AddAttribute ("UniformRv",
                          "Access to the underlying UniformRandomVariable",
                          StringValue ("ns3::UniformRandomVariable"),
                          MakePointerAccessor (&RoutingProtocol::m_URandom),
-                         MakePointerChecker<UniformRandomVariable> ());                                  // the checker is used to set bounds in values
+                         MakePointerChecker<UniformRandomVariable> ())                                   // the checker is used to set bounds in values
+          .AddTraceSource ("HelloTx",
+                           "A HELLO packet was handed to the socket.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_helloTxTrace),
+                           "ns3::dvhop::RoutingProtocol::HelloTxTracedCallback")
+          .AddTraceSource ("FloodingRx",
+                           "A flooding header was received, before it is applied to the table.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_floodingRxTrace),
+                           "ns3::dvhop::RoutingProtocol::FloodingRxTracedCallback")
+          .AddTraceSource ("TableImproved",
+                           "A table entry was created or got a new hop count or hop size.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_tableImprovedTrace),
+                           "ns3::dvhop::RoutingProtocol::TableImprovedTracedCallback")
+          .AddTraceSource ("PositionEstimate",
+                           "The position estimate of a regular node changed, (-1, -1) being no estimate.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_positionEstimateTrace),
+                           "ns3::dvhop::RoutingProtocol::PositionEstimateTracedCallback")
+          .AddTraceSource ("HopSizeChanged",
+                           "The hop size computed by a beacon changed.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_hopSizeChangedTrace),
+                           "ns3::dvhop::RoutingProtocol::HopSizeChangedTracedCallback")
+          .AddTraceSource ("NodeDied",
+                           "The node died in critical mode.",
+                           MakeTraceSourceAccessor (&RoutingProtocol::m_nodeDiedTrace),
+                           "ns3::dvhop::RoutingProtocol::NodeDiedTracedCallback");
       return tid;
     }
 
 
+    ProtocolCounters::ProtocolCounters () :
+      hellosSent (0),
+      helloBytesSent (0),
+      packetsReceived (0),
+      hellosLost (0),
+      duplicates (0),
+      suppressedEntries (0),
+      tableInserts (0),
+      tableImprovements (0),
+      solverRuns (0),
+      solverFailures (0),
+      firstFix (Seconds (-1))
+    {
+    }
+
+    ProtocolCounters&
+    ProtocolCounters::operator+= (const ProtocolCounters &other)
+    {
+      hellosSent += other.hellosSent;
+      helloBytesSent += other.helloBytesSent;
+      packetsReceived += other.packetsReceived;
+      hellosLost += other.hellosLost;
+      duplicates += other.duplicates;
+      suppressedEntries += other.suppressedEntries;
+      tableInserts += other.tableInserts;
+      tableImprovements += other.tableImprovements;
+      solverRuns += other.solverRuns;
+      solverFailures += other.solverFailures;
+      firstFix = std::max (firstFix, other.firstFix);
+      return *this;
+    }
+
+
     /// UDP Port for DV-Hop
     const uint32_t RoutingProtocol::DVHOP_PORT = 1234;
+    /// Bytes taken by the IPv4 and UDP headers in every HELLO
+    const uint32_t RoutingProtocol::IPV4_UDP_OVERHEAD = 20 + 8;
 
 
     RoutingProtocol::RoutingProtocol () :
@@ -58,8 +233,43 @@ namespace ns3 {
       m_hopSize(-1.0),                      // Hop Size
       m_xPosition(-1.0),                   // X Coordinate
       m_yPosition(-1.0),                   // Y Coordinate
-      m_seqNo (0),                          // Current packet sequence number
-      m_totalTime(10)                       // 10 second simulation time by default
+      m_seqNo (0),                          // Beacon sequence number, one per round
+      m_totalTime(10),                      // 10 second simulation time by default
+      m_triggeredUpdates (false),           // Full table in every HELLO
+      m_fullRefreshInterval (Seconds (10)), // Full table every 10 s in triggered mode
+      m_lastFullRefresh (Time::Min ()),     // No full refresh sent yet
+      m_ownEntryDirty (true),               // Own beacon entry not advertised yet
+      m_solver (TRILATERATION),             // Three beacon trilateration
+      m_anchorSumsValid (false),            // Built on the first hop size calculation
+      m_anchorDistSum (0),
+      m_anchorHopSum (0),
+      m_positionUpdateInterval (Seconds (0)), // Estimate on every change
+      m_solveTimer (Timer::CANCEL_ON_DESTROY),
+      m_positionDirty (false),
+      m_wireFormat (FULL_FORMAT),           // 32 byte entries
+      m_coordinateBits (24),
+      m_coordinateResolution (0.01),        // 1 cm
+      m_staleEntryTimeout (Seconds (3)),    // Three HELLO rounds
+      m_helloTimerMode (FIXED_TIMER),       // HELLO every HelloInterval
+      m_trickleImin (Seconds (1)),
+      m_trickleImax (Seconds (64)),
+      m_trickleK (2),
+      m_trickleTimer (Timer::CANCEL_ON_DESTROY),
+      m_lifeTimer (Timer::CANCEL_ON_DESTROY),
+      m_tableChanged (false),
+      m_injecting (false),
+      m_lastTableChange (Seconds (0)),      // No change yet
+      m_positionEpsilon (0.01),             // 1 cm
+      m_estimateMoves (0),
+      m_lastEstimateMove (Seconds (0)),
+      m_fieldWidth (100),                   // 100 m x 100 m area
+      m_fieldHeight (100),
+      m_txPacing (Seconds (0)),             // Back-to-back
+      m_randomStartPhase (true),            // First HELLO at a random point of the first interval
+      m_maxJitter (MilliSeconds (10)),      // Per queued packet
+      m_jitterNeighborReference (10),
+      m_splitHorizon (false),               // Advertise every entry
+      m_neighborTimeout (Seconds (25))
     {
           srandom(m_totalTime);   // For use in random number generation
     }
@@ -74,6 +284,11 @@ namespace ns3 {
     RoutingProtocol::DoDispose ()
     {
       m_ipv4 = 0;
+      for (std::map<Ptr<Socket>, TxQueue>::iterator iter = m_txQueues.begin (); iter != m_txQueues.end (); ++iter)
+        {
+          iter->second.drainEvent.Cancel ();
+        }
+      m_txQueues.clear ();
       //Close every raw socket in the node (one per interface)
       for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::iterator iter =
            m_socketAddresses.begin (); iter != m_socketAddresses.end (); iter++)
@@ -227,7 +442,9 @@ namespace ns3 {
       NS_ASSERT (m_ipv4 == 0);
 
       m_htimer.SetFunction (&RoutingProtocol::HelloTimerExpire, this);
-      m_htimer.Schedule (RoutingProtocol::HelloInterval);
+      m_solveTimer.SetFunction (&RoutingProtocol::UpdatePosition, this);
+      m_trickleTimer.SetFunction (&RoutingProtocol::TrickleIntervalExpire, this);
+      m_lifeTimer.SetFunction (&RoutingProtocol::LifeTimerExpire, this);
 
       m_ipv4 = ipv4;
 
@@ -272,10 +489,12 @@ namespace ns3 {
       NS_ASSERT (socket);
       socket->Close ();
       m_socketAddresses.erase (socket);
+      DropTxQueue (socket);
       if (m_socketAddresses.empty ())
         {
           NS_LOG_LOGIC ("No DV-Hop interfaces");
           m_htimer.Cancel ();
+          m_trickleTimer.Cancel ();
           return;
         }
     }
@@ -322,6 +541,7 @@ namespace ns3 {
       if (socket)
         {
           m_socketAddresses.erase (socket);
+          DropTxQueue (socket);
           Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
           if (l3->GetNAddresses (interface))
             {
@@ -340,6 +560,7 @@ namespace ns3 {
             {
               NS_LOG_LOGIC ("No aodv interfaces");
               m_htimer.Cancel ();
+              m_trickleTimer.Cancel ();
               return;
             }
         }
@@ -373,12 +594,13 @@ namespace ns3 {
 
         Ptr <Ipv4RoutingProtocol> proto = node->GetObject<Ipv4>()->GetRoutingProtocol();
         Ptr <dvhop::RoutingProtocol> dvhop = DynamicCast<dvhop::RoutingProtocol>(proto);
-        if(dvhop->GetXPosition() == -1 && dvhop->GetYPosition() == -1) { // Making sure we were able to calculate location
+        Position estimate = dvhop->GetEstimatedPosition ();
+        if(estimate.first == -1 && estimate.second == -1) { // Making sure we were able to calculate location
           *stream->GetStream() << "Unable to perform Trilateration due either beacons being <3, on the same line or too close" << std::endl;
         }else {
           Ptr <MobilityModel> mob = node->GetObject<MobilityModel>();
           *stream->GetStream() << "Actual Position: (" << mob->GetPosition().x << ", " << mob->GetPosition().y << ")" << std::endl;
-          *stream->GetStream() << "Estimated Position: (" << dvhop->GetXPosition() << ", " << dvhop->GetYPosition() << ")" << std::endl;
+          *stream->GetStream() << "Estimated Position: (" << estimate.first << ", " << estimate.second << ")" << std::endl;
         }
 
         *stream->GetStream() << "Average distance from beacons: " << info.avgDist << std::endl;
@@ -400,7 +622,32 @@ namespace ns3 {
     RoutingProtocol::Start ()
     {
       NS_LOG_FUNCTION (this);
+      // Entries are only confirmed by the full refresh in triggered mode, a shorter
+      // timeout lets the first copy of every refresh replace the shortest path
+      NS_ABORT_MSG_IF (m_triggeredUpdates && m_staleEntryTimeout <= m_fullRefreshInterval,
+                       "StaleEntryTimeout must be longer than FullRefreshInterval with TriggeredUpdates");
       //Initialize timers and extra behaviour not initialized in the constructor
+      if (m_helloTimerMode == TRICKLE_TIMER)
+        {
+          m_htimer.Cancel ();
+          m_trickle.Start (m_trickleImin);
+          StartTrickleInterval ();
+          if (m_isCrit)
+            {
+              m_lifeTimer.Schedule (RoutingProtocol::HelloInterval);
+            }
+        }
+      else
+        {
+          // Nodes started together would otherwise send every HELLO in the same slot
+          Time phase = RoutingProtocol::HelloInterval;
+          if (m_randomStartPhase)
+            {
+              phase = Seconds (m_URandom->GetValue (0, RoutingProtocol::HelloInterval.GetSeconds ()));
+            }
+          m_htimer.Cancel ();
+          m_htimer.Schedule (phase);
+        }
     }
 
 
@@ -409,46 +656,134 @@ namespace ns3 {
     {
       NS_LOG_DEBUG ("HelloTimer expired");
 
-        // Determine if the protocl has has critical conditions enabled
-       if(m_isCrit)
-      {
-        if(m_isAlive) // IF the current Node is flagged as alive
-        {
-          SendHello (); 
-          
-          // Determine if the node survives after sending the hello
-          double currTime = (Simulator::Now()).GetSeconds();
-          u_int32_t chance = (rand()%100) + 1;
-          //std::cout << std::endl<< chance << std::endl<< std::endl;   //<-- Output was used to allow for testing of death chance
-          //td::cout << std::endl<< currTime << "Time of Possible Death" << std::endl<< std::endl;
-
-          // Nodes have a lower chance of dying at later times in the simulation
-          if(!m_isBeacon && 
-          (((currTime > (m_totalTime * 0.15) && currTime < (m_totalTime * 0.30)) && chance < 15) || 
-          ((currTime > (m_totalTime * 0.30) && currTime < (m_totalTime * 0.45)) && chance < 5) || 
-          (((currTime > (m_totalTime * 0.45) && currTime < (m_totalTime)) && chance < 1))))
-          {
-            m_isAlive = false;
-            NS_LOG_LOGIC ("\n\nA Node has Died at time: " << currTime << std::endl); 
-          }
+      // Dead nodes stay silent
+      if (m_isCrit && !m_isAlive)
+        {
+          NS_LOG_LOGIC ("\n\n@" << Simulator::Now() << " , Hello fails.\n\n");
+          return;
+        }
+
+      if (m_helloTimerMode == TRICKLE_TIMER)
+        {
+          // Suppress the transmission if enough neighbours already advertised consistent tables
+          if (!m_trickle.IsSuppressed (m_trickleK))
+            {
+              SendHello ();
+            }
           else
-          {
-            // Ensure the next time gets scheduled
-            m_htimer.Cancel ();
-            m_htimer.Schedule (RoutingProtocol::HelloInterval);
-          }
+            {
+              NS_LOG_LOGIC ("HELLO suppressed, " << m_trickle.GetCounter () << " consistent advertisements heard");
+            }
+          // The next transmission is scheduled by the next interval
+          return;
+        }
 
-        }  
-        else
-          NS_LOG_LOGIC ("\n\n@" << Simulator::Now() << " , Hello fails.\n\n");
-      }
-      else
+      SendHello ();
+      // Determine if the node survives after sending the hello
+      if (m_isCrit && CheckNodeDeath ())
+        {
+          return;
+        }
+      // Ensure the next time gets scheduled
+      m_htimer.Cancel ();
+      m_htimer.Schedule (RoutingProtocol::HelloInterval);
+    }
+
+    bool
+    RoutingProtocol::CheckNodeDeath ()
+    {
+      double currTime = (Simulator::Now()).GetSeconds();
+      u_int32_t chance = (rand()%100) + 1;
+      //std::cout << std::endl<< chance << std::endl<< std::endl;   //<-- Output was used to allow for testing of death chance
+      //td::cout << std::endl<< currTime << "Time of Possible Death" << std::endl<< std::endl;
+
+      // Nodes have a lower chance of dying at later times in the simulation
+      if(!m_isBeacon && 
+      (((currTime > (m_totalTime * 0.15) && currTime < (m_totalTime * 0.30)) && chance < 15) || 
+      ((currTime > (m_totalTime * 0.30) && currTime < (m_totalTime * 0.45)) && chance < 5) || 
+      (((currTime > (m_totalTime * 0.45) && currTime < (m_totalTime)) && chance < 1))))
       {
-        // Send Hello without critical conditions
-        SendHello ();
+        m_isAlive = false;
         m_htimer.Cancel ();
-        m_htimer.Schedule (RoutingProtocol::HelloInterval);
+        m_trickleTimer.Cancel ();
+        m_lifeTimer.Cancel ();
+        m_nodeDiedTrace ();
+        NS_LOG_LOGIC ("\n\nA Node has Died at time: " << currTime << std::endl); 
+        return true;
       }
+      return false;
+    }
+
+    void
+    RoutingProtocol::LifeTimerExpire ()
+    {
+      // Trickle transmissions are irregular, so keep one death draw per HelloInterval as in fixed mode
+      if (!CheckNodeDeath ())
+        {
+          m_lifeTimer.Schedule (RoutingProtocol::HelloInterval);
+        }
+    }
+
+    void
+    RoutingProtocol::StartTrickleInterval ()
+    {
+      // RFC 6206 4.2: reset the counter and pick the transmission time in [I/2, I)
+      double interval = m_trickle.GetInterval ().GetSeconds ();
+      m_htimer.Cancel ();
+      m_htimer.Schedule (Seconds (m_URandom->GetValue (interval / 2, interval)));
+      m_trickleTimer.Cancel ();
+      m_trickleTimer.Schedule (m_trickle.GetInterval ());
+    }
+
+    void
+    RoutingProtocol::TrickleIntervalExpire ()
+    {
+      // Consistent interval: double it up to Imax
+      m_trickle.Double (m_trickleImax);
+      NS_LOG_LOGIC ("Trickle interval doubled to " << m_trickle.GetInterval ().GetSeconds () << " s");
+      StartTrickleInterval ();
+    }
+
+    void
+    RoutingProtocol::TrickleReset ()
+    {
+      if (m_helloTimerMode != TRICKLE_TIMER || (m_isCrit && !m_isAlive))
+        return;
+      // An inconsistency at the minimum interval does not restart it
+      if (m_trickle.Reset (m_trickleImin))
+        {
+          NS_LOG_LOGIC ("Inconsistency, Trickle interval reset to " << m_trickleImin.GetSeconds () << " s");
+          StartTrickleInterval ();
+        }
+    }
+
+    bool
+    RoutingProtocol::IsConsistent (const FloodingHeader &advertised) const
+    {
+      uint16_t seqNo, hops;
+      double hopSize;
+      if (m_ipv4->GetInterfaceForAddress (advertised.GetBeaconAddress ()) >= 0)
+        {// Our own beacon entry relayed back
+          if (!m_isBeacon)
+            return false;
+          seqNo = m_seqNo;
+          hops = 0;
+          hopSize = m_hopSize;
+        }
+      else
+        {
+          const BeaconInfo *entry = m_disTable.Find (advertised.GetBeaconAddress ());
+          if (!entry)
+            return false;
+          seqNo = entry->GetSequenceNumber ();
+          hops = entry->GetHops ();
+          hopSize = entry->GetHopSize ();
+        }
+
+      // The compact format rounds hop sizes to the coordinate resolution
+      double tolerance = m_wireFormat == COMPACT_FORMAT ? m_coordinateResolution : 0;
+      return IsConsistentAdvertisement (advertised.GetSequenceNumber (), advertised.GetHopCount (),
+                                        advertised.GetHopSize (), seqNo, hops, hopSize, tolerance);
     }
 
     bool
@@ -463,80 +798,192 @@ namespace ns3 {
     void
     RoutingProtocol::SendHello ()
     {
+      DVHOP_PROFILE_SCOPE ("RoutingProtocol::SendHello");
       //NS_LOG_FUNCTION (this);
-      /* Broadcast a HELLO packet the message fields set as follows:
-   *   Sequence Number    The node's latest sequence number.
-   *   Hop Count                      0
+      /* Broadcast the HELLO packets with every known beacon entry batched
+   * in as few packets as the interface MTU allows:
+   *   Sequence Number    The beacon's sequence number of the round that confirmed the entry.
+   *   Hop Count          Hops to the beacon (0 for this node if it is a beacon)
+   * In triggered mode only the entries changed since the last HELLO are sent,
+   * except every FullRefreshInterval.
+   * With split horizon, entries that no neighbour would accept are left out,
+   * except every FullRefreshInterval so that unheard neighbours catch up.
    */
+      bool periodicRefresh = Simulator::Now () - m_lastFullRefresh >= m_fullRefreshInterval;
+      bool fullRefresh = !m_triggeredUpdates || periodicRefresh;
+      bool filter = m_splitHorizon && !periodicRefresh;
+      if (filter)
+        {
+          PurgeNeighbors ();
+        }
+      // One sequence number per round that advertises the beacon entry, so every
+      // new number leaves with this HELLO instead of waiting for the next full refresh
+      bool advertiseOwn = m_isBeacon && (fullRefresh || m_ownEntryDirty);
+      if (advertiseOwn)
+        {
+          m_seqNo++;
+        }
 
       for(std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin(); j != m_socketAddresses.end (); ++j)
         {
           Ptr<Socket> socket = j->first;
           Ipv4InterfaceAddress iface = j->second;
 
-          std::vector<Ipv4Address> knownBeacons = m_disTable.GetKnownBeacons ();
-          std::vector<Ipv4Address>::const_iterator addr;
-          for (addr = knownBeacons.begin (); addr != knownBeacons.end (); ++addr)
+          // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+          Ipv4Address destination;
+          if (iface.GetMask () == Ipv4Mask::GetOnes ())
+            {
+              destination = Ipv4Address ("255.255.255.255");
+            }
+          else
+            {
+              destination = iface.GetBroadcast ();
+            }
+
+          FloodingBatchHeader batch;
+          if (m_wireFormat == COMPACT_FORMAT)
+            {
+              batch.SetCompact (m_coordinateBits, m_coordinateResolution);
+            }
+
+          // Split the table in batches that fit the interface MTU
+          uint32_t mtu = m_ipv4->GetMtu (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()));
+          uint16_t maxEntries = batch.GetMaxEntries (mtu - IPV4_UDP_OVERHEAD);
+
+          for (DistanceTable::Iterator entry = m_disTable.Begin (); entry != m_disTable.End (); ++entry)
             {
-              //Create a HELLO Packet for each known Beacon to this node
-              Position beaconPos = m_disTable.GetBeaconPosition (*addr);
-              FloodingHeader helloHeader(beaconPos.first,              //X Position
-                                         beaconPos.second,             //Y Position
-                                         m_seqNo++,                    //Sequence Numbr
-                                         m_disTable.GetHopsTo (*addr), //Hop Count
-                                         m_disTable.GetHopSizeOf (*addr), //Hop Size
-                                         *addr);                       //Beacon Address
-              NS_LOG_DEBUG (iface.GetLocal ()<< " Sending Hello...");
-              Ptr<Packet> packet = Create<Packet>();
-              packet->AddHeader (helloHeader);
-              // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-              Ipv4Address destination;
-              if (iface.GetMask () == Ipv4Mask::GetOnes ())
+              if (!fullRefresh && !entry->IsDirty ())
                 {
-                  destination = Ipv4Address ("255.255.255.255");
+                  continue; // Neighbours already got this entry
                 }
-              else
+              if (filter && !m_neighbors.IsNeeded (entry->GetAddress (), entry->GetHops (), entry->GetSequenceNumber (),
+                                                   entry->GetHopSize (), m_staleEntryTimeout))
                 {
-                  destination = iface.GetBroadcast ();
+                  m_counters.suppressedEntries++;
+                  continue; // Every neighbour holds this beacon at least as well
                 }
-              Time jitter = Time (MilliSeconds (m_URandom->GetInteger (0, 10)));
-              Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this , socket, packet, destination);
+              //Add an entry for each known Beacon to this node
+              Position beaconPos = entry->GetPosition ();
+              AppendEntry (batch, FloodingHeader (beaconPos.first,              //X Position
+                                                  beaconPos.second,             //Y Position
+                                                  entry->GetSequenceNumber (),  //Beacon Sequence Number
+                                                  entry->GetHops (),            //Hop Count
+                                                  entry->GetHopSize (),         //Hop Size
+                                                  entry->GetAddress ()),        //Beacon Address
+                           maxEntries, socket, destination);
             }
 
           /*If this node is a beacon, it should broadcast its position always*/
           NS_LOG_DEBUG ("Node "<< iface.GetLocal () << " isBeacon? " << m_isBeacon);
-          if (m_isBeacon){
-              //Create a HELLO Packet for each known Beacon to this node
-              FloodingHeader helloHeader(m_xPosition,                 //X Position
-                                         m_yPosition,                 //Y Position
-                                         m_seqNo++,                   //Sequence Number
-                                         0,                           //Hop Count
-                                         m_hopSize,                   //Hop Size
-                                         iface.GetLocal ());          //Beacon Address
-//              std::cout <<__FILE__<< __LINE__ << helloHeader << std::endl;
-
-              NS_LOG_DEBUG (iface.GetLocal ()<< " Sending Hello...");
-              Ptr<Packet> packet = Create<Packet>();
-              packet->AddHeader (helloHeader);
-              // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-              Ipv4Address destination;
-              if (iface.GetMask () == Ipv4Mask::GetOnes ())
-                {
-                  destination = Ipv4Address ("255.255.255.255");
-                }
-              else
-                {
-                  destination = iface.GetBroadcast ();
-                }
-              Time jitter = Time (MilliSeconds (m_URandom->GetInteger (0, 10)));
-              Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this , socket, packet, destination);
-
+          if (advertiseOwn){
+              AppendEntry (batch, FloodingHeader (m_xPosition,                 //X Position
+                                                  m_yPosition,                 //Y Position
+                                                  m_seqNo,                     //Sequence Number
+                                                  0,                           //Hop Count
+                                                  m_hopSize,                   //Hop Size
+                                                  iface.GetLocal ()),          //Beacon Address
+                           maxEntries, socket, destination);
+            }
 
+          if (batch.GetNEntries () > 0)
+            {
+              SendBatch (socket, batch, destination);
             }
+          ScheduleDrain (socket);
+        }
+
+      if (periodicRefresh)
+        {
+          m_lastFullRefresh = Simulator::Now ();
+        }
+      m_disTable.ClearDirty ();
+      m_ownEntryDirty = false;
+    }
+
+    void
+    RoutingProtocol::AppendEntry (FloodingBatchHeader &batch, const FloodingHeader &entry, uint16_t maxEntries,
+                                  Ptr<Socket> socket, Ipv4Address destination)
+    {
+      // Send the current batch first if it is full or cannot encode this entry
+      if (batch.GetNEntries () == maxEntries || !batch.CanAdd (entry))
+        {
+          SendBatch (socket, batch, destination);
+          batch.Clear ();
+        }
+      batch.AddEntry (entry);
+    }
+
+    void
+    RoutingProtocol::SendBatch (Ptr<Socket> socket, const FloodingBatchHeader &batch, Ipv4Address destination)
+    {
+      NS_LOG_DEBUG ("Queueing Hello with " << batch.GetNEntries () << " entries...");
+      TxQueue &queue = m_txQueues[socket];
+
+      // Receivers count the gaps in the counter as lost HELLOs
+      FloodingBatchHeader header = batch;
+      header.SetHelloCounter (queue.helloCounter++);
+      Ptr<Packet> packet = Create<Packet>();
+      packet->AddHeader (header);
+
+      queue.packets.push_back (packet);
+      queue.destination = destination;
+    }
+
+    void
+    RoutingProtocol::ScheduleDrain (Ptr<Socket> socket)
+    {
+      std::map<Ptr<Socket>, TxQueue>::iterator it = m_txQueues.find (socket);
+      if (it == m_txQueues.end () || it->second.packets.empty () || it->second.drainEvent.IsRunning ())
+        return;
+      TxQueue &queue = it->second;
+
+      // One jittered event per interface and round, whatever the number of batches. The
+      // window grows with the airtime this round needs and with the number of neighbours
+      // contending for the channel, so dense areas spread their rounds further apart.
+      double scale = queue.packets.size ()
+        * std::max (1.0, double (GetNeighborDensity ()) / m_jitterNeighborReference);
+      double window = std::min (m_maxJitter.GetSeconds () * scale, RoutingProtocol::HelloInterval.GetSeconds () / 2);
+      Time jitter = Seconds (m_URandom->GetValue (0, window));
+      queue.drainEvent = Simulator::Schedule (jitter, &RoutingProtocol::DrainTxQueue, this, socket);
+    }
+
+    void
+    RoutingProtocol::DrainTxQueue (Ptr<Socket> socket)
+    {
+      std::map<Ptr<Socket>, TxQueue>::iterator it = m_txQueues.find (socket);
+      if (it == m_txQueues.end ())
+        return;
+      TxQueue &queue = it->second;
+
+      // Back-to-back, or one packet every TxPacing
+      do
+        {
+          m_helloTxTrace (queue.packets.front (), queue.destination);
+          m_counters.hellosSent++;
+          m_counters.helloBytesSent += queue.packets.front ()->GetSize () + IPV4_UDP_OVERHEAD;
+          SendTo (socket, queue.packets.front (), queue.destination);
+          queue.packets.pop_front ();
+        }
+      while (!queue.packets.empty () && m_txPacing.IsZero ());
+
+      if (!queue.packets.empty ())
+        {
+          queue.drainEvent = Simulator::Schedule (m_txPacing, &RoutingProtocol::DrainTxQueue, this, socket);
         }
     }
 
 
+    void
+    RoutingProtocol::DropTxQueue (Ptr<Socket> socket)
+    {
+      std::map<Ptr<Socket>, TxQueue>::iterator it = m_txQueues.find (socket);
+      if (it != m_txQueues.end ())
+        {
+          it->second.drainEvent.Cancel ();
+          m_txQueues.erase (it);
+        }
+    }
+
     void
     RoutingProtocol::SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
     {
@@ -566,24 +1013,108 @@ namespace ns3 {
     void
     RoutingProtocol::Recieve(Ptr<Socket> socket)
     {
+      DVHOP_PROFILE_SCOPE ("RoutingProtocol::Recieve");
+      std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator iface = m_socketAddresses.find (socket);
+      if (iface == m_socketAddresses.end ())
+        {
+          NS_LOG_LOGIC ("Packet on a socket without interface, ignored");
+          return;
+        }
+      NS_LOG_DEBUG ("receiver:         " << iface->second.GetLocal ());
+
+      // Drain every queued datagram and apply all entries first, then do the
+      // derived work once for the whole drain
+      bool changed = false;
+      bool inconsistent = false;
+      uint32_t consistent = 0;
       Address sourceAddress;
-      Ptr<Packet> packet = socket->RecvFrom (sourceAddress); //Read a single packet from 'socket' and retrieve the 'sourceAddress'
+      Ptr<Packet> packet;
+      while ((packet = socket->RecvFrom (sourceAddress)))
+        {
+          Ipv4Address sender = InetSocketAddress::ConvertFrom (sourceAddress).GetIpv4 ();
+          NS_LOG_DEBUG ("sender:           " << sender);
 
-      InetSocketAddress inetSourceAddr = InetSocketAddress::ConvertFrom (sourceAddress);
-      Ipv4Address sender = inetSourceAddr.GetIpv4 ();
-      Ipv4Address receiver = m_socketAddresses[socket].GetLocal ();
+          FloodingBatchHeader batch;
+          if (packet->RemoveHeader (batch) == 0)
+            {
+              NS_LOG_WARN ("HELLO with an unknown version from " << sender << " dropped");
+              continue;
+            }
+          uint16_t lost = m_neighbors.RecordHello (sender, batch.GetHelloCounter ());
+          m_counters.packetsReceived++;
+          if (lost > 0)
+            {
+              m_counters.hellosLost += lost;
+              NS_LOG_LOGIC (lost << " HELLO(s) from " << sender << " lost");
+            }
 
-      NS_LOG_DEBUG ("sender:           " << sender);
-      NS_LOG_DEBUG ("receiver:         " << receiver);
+          m_tableChanged = false;
+          bool allConsistent = batch.GetNEntries () > 0;
+          for (uint16_t k = 0; k < batch.GetNEntries (); ++k)
+            {
+              const FloodingHeader &fHeader = batch.GetEntry (k);
+              m_floodingRxTrace (fHeader, sender);
+              m_neighbors.RecordAdvertisement (sender, fHeader.GetBeaconAddress (), fHeader.GetHopCount (),
+                                               fHeader.GetSequenceNumber (), fHeader.GetHopSize ());
+              NS_LOG_DEBUG ("Update the entry for: " << fHeader.GetBeaconAddress ());
+              changed |= UpdateHopsTo (fHeader.GetBeaconAddress (), fHeader.GetHopCount () + 1, fHeader.GetHopSize (),
+                                       fHeader.GetXPosition (), fHeader.GetYPosition (), fHeader.GetSequenceNumber ());
+              allConsistent = allConsistent && IsConsistent (fHeader);
+              NS_LOG_LOGIC ( "Header Dump Post Recieve (Beacon IP/Hop Count/ (X,Y) of Beacon): " << fHeader.GetBeaconAddress() 
+                << " / " << fHeader.GetHopCount() << " / ( "  << fHeader.GetXPosition() << " , " << fHeader.GetYPosition() << " ) \n"); 
+            }
 
+          // Trickle: each datagram is one advertisement heard. It is consistent only
+          // when every entry matches the table, a neighbour rounds behind or on a
+          // worse path is inconsistent even if we learned nothing
+          if (allConsistent && !m_tableChanged)
+            {
+              consistent++;
+            }
+          else if (batch.GetNEntries () > 0)
+            {
+              inconsistent = true;
+            }
+        }
 
-      FloodingHeader fHeader;
-      packet->RemoveHeader (fHeader);
-      NS_LOG_DEBUG ("Update the entry for: " << fHeader.GetBeaconAddress ());
-      UpdateHopsTo (fHeader.GetBeaconAddress (), fHeader.GetHopCount () + 1, fHeader.GetHopSize (), fHeader.GetXPosition (), fHeader.GetYPosition ());
-      NS_LOG_LOGIC ( "Header Dump Post Recieve (Beacon IP/Hop Count/ (X,Y) of Beacon): " << fHeader.GetBeaconAddress() 
-        << " / " << fHeader.GetHopCount() << " / ( "  << fHeader.GetXPosition() << " , " << fHeader.GetYPosition() << " ) \n"); 
+      m_tableChanged = false;
+      if (changed)
+        {
+          if (m_isBeacon)
+            { // Recalculate hop sizes to other beacons
+              RecalculateHopSize ();
+            }
+          else
+            {
+              SchedulePositionUpdate ();
+            }
+        }
+
+      // Trickle: new information resets the interval, consistent advertisements count towards suppression
+      if (inconsistent || m_tableChanged)
+        {
+          m_tableChanged = false;
+          TrickleReset ();
+        }
+      else
+        {
+          m_trickle.AddConsistent (consistent);
+        }
+    }
 
+    uint32_t
+    RoutingProtocol::GetNeighborDensity ()
+    {
+      PurgeNeighbors ();
+      return m_neighbors.GetSize ();
+    }
+
+    void
+    RoutingProtocol::PurgeNeighbors ()
+    {
+      // Forget the neighbours not heard within NeighborTimeout, or two HELLO periods if longer
+      Time period = m_helloTimerMode == TRICKLE_TIMER ? m_trickle.GetInterval () : RoutingProtocol::HelloInterval;
+      m_neighbors.Purge (Simulator::Now () - std::max (m_neighborTimeout, period + period));
     }
 
     Ptr<Socket>
@@ -602,107 +1133,288 @@ namespace ns3 {
       return socket;
     }
 
-    void
-    RoutingProtocol::UpdateHopsTo (Ipv4Address beacon, uint16_t newHops, double newHopSize, double x, double y)
+    bool
+    RoutingProtocol::UpdateHopsTo (Ipv4Address beacon, uint16_t newHops, double newHopSize, double x, double y, uint16_t seqNo)
     {
-      uint16_t oldHops = m_disTable.GetHopsTo (beacon);
-      double oldHopSize = m_disTable.GetHopSizeOf (beacon);
+      DVHOP_PROFILE_SCOPE ("RoutingProtocol::UpdateHopsTo");
       if (m_ipv4->GetInterfaceForAddress (beacon) >= 0){
           NS_LOG_DEBUG ("Local Address, not updating in table");
-          return;
+          return false;
         }
+      const BeaconInfo *entry = m_disTable.Find (beacon);
+      uint16_t oldHops = entry ? entry->GetHops () : 0;
+      double oldHopSize = entry ? entry->GetHopSize () : -1.0;
 
-      if( oldHops > newHops || oldHops == 0) {//Update only when a shortest path is found
-        m_disTable.AddBeacon(beacon, newHops, newHopSize > 0? newHopSize:oldHopSize, x, y);
+      // The position of a known beacon never changes
+      Position pos = entry ? entry->GetPosition () : Position (x, y);
 
-        if(m_isBeacon) { // Recalculate hop sizes to other beacons
-          RecalculateHopSize();
-        }else if( newHopSize > 0 || oldHopSize > 0 ) {
-          Trilateration();
+      if (entry && IsNewerSequenceNumber (entry->GetSequenceNumber (), seqNo))
+        {
+          NS_LOG_LOGIC ("Stale entry for " << beacon << " dropped");
+          m_counters.duplicates++;
+          return false;
         }
-      } else if( newHopSize > 0 && !m_isBeacon) {//Also update hop size if its available only for regular nodes, but hop counts remains
-        m_disTable.AddBeacon(beacon, oldHops, newHopSize, x, y);
-        Trilateration();
-      }
+      // Whether this entry may set the hop count, as in DSDV
+      bool acceptPath = m_disTable.AcceptsPath (beacon, newHops, seqNo, m_staleEntryTimeout);
+
+      //Also update hop size if a new one is available only for regular nodes, but hop counts remains
+      if (!acceptPath && (newHopSize <= 0 || newHopSize == oldHopSize || m_isBeacon))
+        {
+          NS_LOG_LOGIC ("Duplicate entry for " << beacon << " dropped");
+          m_counters.duplicates++;
+          return false;
+        }
+
+      uint16_t hops = acceptPath ? newHops : oldHops;
+      double hopSize = newHopSize > 0? newHopSize:oldHopSize;
+      if (entry && hops == oldHops && hopSize == oldHopSize)
+        {// Nothing changed, only confirm the current path
+          m_disTable.Refresh (beacon, seqNo);
+          m_counters.duplicates++;
+          return false;
+        }
+
+      uint32_t slot = m_disTable.AddBeacon(beacon, hops, hopSize, x, y);
+      if (!m_injecting)
+        {// Warm start entries were not learned from the network
+          m_tableImprovedTrace (beacon, oldHops, hops, hopSize);
+          if (entry)
+            m_counters.tableImprovements++;
+          else
+            m_counters.tableInserts++;
+        }
+      m_tableChanged = true;
+      m_lastTableChange = Simulator::Now ();
+      if (acceptPath)
+        {
+          m_disTable.Refresh (beacon, seqNo);
+        }
+      if (m_isBeacon)
+        {
+          UpdateAnchorSums (slot, oldHops, hops);
+        }
+      UpdateSolverInput (pos, oldHops, oldHopSize, hops, hopSize);
+
+      // Beacons recalculate hop sizes to other beacons, regular nodes trilaterate once hop sizes are known
+      return m_isBeacon ? hops != oldHops : hopSize > 0;
     }
 
-    // Calculate the ho size of a beacon = Sum (all other anchors as i) SQRT((x-xi)^2 + (y-yi)^2)
+    void
+    RoutingProtocol::UpdateSolverInput (const Position &pos, uint16_t oldHops, double oldHopSize, uint16_t newHops, double newHopSize)
+    {
+      // Only beacons with a known hop size give a distance estimate
+      if (oldHops > 0 && oldHopSize > 0)
+        {
+          m_lsSolver.Remove (pos.first, pos.second, oldHopSize * oldHops);
+        }
+      if (newHopSize > 0)
+        {
+          m_lsSolver.Add (pos.first, pos.second, newHopSize * newHops);
+        }
+    }
+
+    void
+    RoutingProtocol::UpdateAnchorSums (uint32_t slot, uint16_t oldHops, uint16_t newHops)
+    {
+      if (!m_anchorSumsValid)
+        {
+          return; // RecalculateHopSize rebuilds the sums from the table
+        }
+
+      if (slot == m_anchorDistances.size ())
+        {// A newly discovered anchor, its distance is computed only once
+          const Position &beaconPos = m_disTable.GetEntry (slot).GetPosition ();
+          double dist = sqrt(pow(m_xPosition-beaconPos.first, 2) + pow(m_yPosition-beaconPos.second, 2));
+          m_anchorDistances.push_back (dist);
+          m_anchorDistSum += dist;
+        }
+      m_anchorHopSum += (double) newHops - oldHops;
+    }
+
+    // Calculate the ho size of a beacon = Sum (all other anchors as i) SQRT((x-xi)^2 + (y-yi)^2) / Sum hops
     void
     RoutingProtocol::RecalculateHopSize ()
     {
-      double up = 0;
-      double down = 0;
+      DVHOP_PROFILE_SCOPE ("RoutingProtocol::RecalculateHopSize");
+      if (!m_anchorSumsValid)
+        {// Build the running sums from the whole table, they are kept up to date by UpdateAnchorSums afterwards
+          m_anchorDistances.clear ();
+          m_anchorDistSum = 0;
+          m_anchorHopSum = 0;
+          for (DistanceTable::Iterator entry = m_disTable.Begin (); entry != m_disTable.End (); ++entry) {
+            const Position &beaconPos = entry->GetPosition ();
+            double dist = sqrt(pow(m_xPosition-beaconPos.first, 2) + pow(m_yPosition-beaconPos.second, 2));
+
+            m_anchorDistances.push_back (dist);
+            m_anchorDistSum += dist;
+            m_anchorHopSum += entry->GetHops ();
+          }
+          m_anchorSumsValid = true;
+        }
 
-      std::vector<Ipv4Address> knownBeacons = m_disTable.GetKnownBeacons ();
-      std::vector<Ipv4Address>::const_iterator addr;
-      for (addr = knownBeacons.begin (); addr != knownBeacons.end (); ++addr) {
-        Position beaconPos = m_disTable.GetBeaconPosition(*addr);
-        double hops = m_disTable.GetHopsTo(*addr);
+      if (m_anchorHopSum == 0)
+        {
+          return; // No other anchor reached yet, keep the current hop size
+        }
+      double hopSize = m_anchorDistSum/m_anchorHopSum;
+      if (hopSize != m_hopSize)
+        {
+          m_hopSizeChangedTrace (m_hopSize, hopSize);
+          m_hopSize = hopSize;
+          m_ownEntryDirty = true;
+          m_tableChanged = true;
+          m_lastTableChange = Simulator::Now ();
+        }
+    }
 
-        up += sqrt(pow(m_xPosition-beaconPos.first, 2) + pow(m_yPosition-beaconPos.second, 2));
-        down += hops;
-      }
+    void
+    RoutingProtocol::SchedulePositionUpdate ()
+    {
+      m_positionDirty = true;
+      if (m_positionUpdateInterval.IsZero ())
+        {
+          UpdatePosition ();
+        }
+      else if (!m_solveTimer.IsRunning ())
+        {
+          // Coalesce every change until the timer expires
+          m_solveTimer.Schedule (m_positionUpdateInterval);
+        }
+    }
+
+    void
+    RoutingProtocol::UpdatePosition ()
+    {
+      if (m_positionDirty)
+        {
+          m_positionDirty = false;
+          Trilateration ();
+        }
+    }
 
-      m_hopSize = up/down;
+    Position
+    RoutingProtocol::GetEstimatedPosition ()
+    {
+      UpdatePosition ();
+      return Position (m_xPosition, m_yPosition);
     }
 
     void
     RoutingProtocol::Trilateration() {
-      Point points[3];
-      double distances[3];
+      DVHOP_PROFILE_SCOPE ("RoutingProtocol::Trilateration");
+      double x, y;
+      m_counters.solverRuns++;
+
+      if (m_solver == LEAST_SQUARES)
+        {
+          // Every beacon with a valid hop size is already in the normal equations
+          if (!m_lsSolver.Solve (x, y))
+            {
+              m_counters.solverFailures++;
+              return; // Less than 3 beacons, or collinear
+            }
+        }
+      else
+        {
+          double xs[3], ys[3];
+          double distances[3];
 
-      uint16_t counter = 0;
-//      *os->GetStream () << "Trilateration Distance entries\n";
+          // The three beacons with the lowest addresses, so the estimate does not depend on arrival order
+          const BeaconInfo *chosen[3];
+          uint32_t counter = m_disTable.SelectLowestAddresses (chosen, 3);
+          for (uint32_t i = 0; i < counter; ++i)
+            {
+              xs[i] = chosen[i]->GetPosition ().first;
+              ys[i] = chosen[i]->GetPosition ().second;
+              distances[i] = chosen[i]->GetHopSize () * chosen[i]->GetHops ();
+            }
 
-      std::vector<Ipv4Address> knownBeacons = m_disTable.GetKnownBeacons ();
-      std::vector<Ipv4Address>::const_iterator addr;
-      for (addr = knownBeacons.begin (); addr != knownBeacons.end (); ++addr) 
-      {
-        Position beaconPos = m_disTable.GetBeaconPosition(*addr);
-        if(m_disTable.GetHopSizeOf(*addr) < 0) {
-          continue; // Ignore Beacon with no valid hop size
+          if(counter<3 || !Trilaterate (xs, ys, distances, x, y))
+          {
+            // We did not get upto 3 beacons, or they are collinear or too close
+            m_counters.solverFailures++;
+            return;
+          }
         }
-        points[counter] = {beaconPos.first, beaconPos.second};
-        distances[counter] = m_disTable.GetHopSizeOf(*addr) * m_disTable.GetHopsTo(*addr);
 
-        // Beacon IP Address     Distance
-//        *os->GetStream () << addr << "\t" << distances[counter] << std::endl;
-        counter++;
-        if(counter==3) break;
-      }
+      // Bounding the position to the simulation area
+      if(x < 0) x = 0;
+      else if(x > m_fieldWidth) x = m_fieldWidth;
+      if(y < 0) y = 0;
+      else if(y > m_fieldHeight) y = m_fieldHeight;
 
-      if(counter<3) 
-      { 
-        // We did not get upto 3 beacons to trilaterate
-//        *os->GetStream () << "No enough points for trilateration!" << std::endl;
-        return;
-      }
-      double ex = points[1].x - points[0].x;
-      double ey = points[1].y - points[0].y;
-      double ez = points[1].x * points[1].x - points[0].x * points[0].x +
-                  points[1].y * points[1].y - points[0].y * points[0].y +
-                  distances[0] * distances[0] - distances[1] * distances[1];
-
-      double fx = points[2].x - points[0].x;
-      double fy = points[2].y - points[0].y;
-      double fz = points[2].x * points[2].x - points[0].x * points[0].x +
-                  points[2].y * points[2].y - points[0].y * points[0].y +
-                  distances[0] * distances[0] - distances[2] * distances[2];
-
-      double denominator = 2 * (ex * fy - ey * fx);
-      if (std::abs(denominator) < 1e-6) {
-//        *os->GetStream () << "The points are collinear or too close for trilateration!" << std::endl;
-        return;
-      }
+      // Count the estimates that moved noticeably, the first fix included
+      double dx = x - m_xPosition;
+      double dy = y - m_yPosition;
+      if (!HasPositionFix ())
+        {
+          m_counters.firstFix = Simulator::Now ();
+        }
+      if (!HasPositionFix () || dx * dx + dy * dy > m_positionEpsilon * m_positionEpsilon)
+        {
+          m_estimateMoves++;
+          m_lastEstimateMove = Simulator::Now ();
+        }
+
+      if (x != m_xPosition || y != m_yPosition)
+        {
+          m_positionEstimateTrace (Position (m_xPosition, m_yPosition), Position (x, y));
+        }
+      m_xPosition = x;
+      m_yPosition = y;
+    }
+
+    void
+    RoutingProtocol::InjectBeacon (Ipv4Address beacon, uint16_t hops, double hopSize, double x, double y)
+    {
+      NS_LOG_FUNCTION (this << beacon << hops << hopSize);
+      // Sequence number 0 is older than the first round of every beacon, so the
+      // first HELLOs only confirm the injected entries
+      m_injecting = true;
+      UpdateHopsTo (beacon, hops, hopSize, x, y, 0);
+      m_injecting = false;
+    }
+
+    Ipv4Address
+    RoutingProtocol::GetBeaconAddress () const
+    {
+      for (uint32_t i = 0; i < m_ipv4->GetNInterfaces (); ++i)
+        {
+          if (m_ipv4->GetNAddresses (i) > 0 && FindSocketWithInterfaceAddress (m_ipv4->GetAddress (i, 0)))
+            {
+              return m_ipv4->GetAddress (i, 0).GetLocal ();
+            }
+        }
+      return Ipv4Address ();
+    }
+
+    void
+    RoutingProtocol::FinishWarmStart ()
+    {
+      if (m_isBeacon)
+        {
+          RecalculateHopSize ();
+        }
+      else
+        {
+          m_positionDirty = true;
+          UpdatePosition ();
+        }
+      // The network starts converged: no Trickle reset, no change to report
+      m_tableChanged = false;
+    }
 
-      m_xPosition = (ez * fy - ey * fz) / denominator;
-      m_yPosition = (ex * fz - ez * fx) / denominator;
+    bool
+    RoutingProtocol::HasPositionFix () const
+    {
+      return m_isBeacon || m_xPosition != -1.0 || m_yPosition != -1.0;
+    }
 
-      // Bounding the position to the simulation area 100 x 100
-      if(m_xPosition < 0) m_xPosition = 0;
-      else if(m_xPosition > 100) m_xPosition = 100;
-      if(m_yPosition < 0) m_yPosition = 0;
-      else if(m_yPosition > 100) m_yPosition = 100;
+    Time
+    RoutingProtocol::GetLastChange ()
+    {
+      UpdatePosition ();
+      return std::max (m_lastTableChange, m_lastEstimateMove);
     }
 
     Data
@@ -716,19 +1428,17 @@ namespace ns3 {
 
       Data output;
 
-      uint16_t counter = 0;
-      std::vector<Ipv4Address> knownBeacons = m_disTable.GetKnownBeacons ();
-      std::vector<Ipv4Address>::const_iterator addr;
-      for (addr = knownBeacons.begin (); addr != knownBeacons.end (); ++addr) {
-        Position beaconPos = m_disTable.GetBeaconPosition(*addr);
+      // The beacons Trilateration uses
+      const BeaconInfo *chosen[3];
+      uint32_t n = m_disTable.SelectLowestAddresses (chosen, 3);
+      for (uint32_t counter = 0; counter < n; ++counter) {
+        Position beaconPos = chosen[counter]->GetPosition ();
         points[counter] = {beaconPos.first, beaconPos.second};
-        distances[counter] = m_disTable.GetHopSizeOf(*addr) * m_disTable.GetHopsTo(*addr);
+        distances[counter] = chosen[counter]->GetHopSize () * chosen[counter]->GetHops ();
 
         totalDist += (double)distances[counter];
-        totalLat +=  m_disTable.LastUpdatedAt(*addr).GetDouble();
-        totalHops += m_disTable.GetHopsTo(*addr);
-        counter++;
-        if(counter==3) break;
+        totalLat +=  chosen[counter]->GetTime ().GetDouble();
+        totalHops += chosen[counter]->GetHops ();
       }
 
       output.avgDist = totalDist / 3.0;
@@ -10,12 +10,19 @@
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/timer.h"
+#include "ns3/traced-callback.h"
+#include "ns3/event-id.h"
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/mobility-module.h"
 
 #include "distance-table.h"
+#include "neighbor-table.h"
+#include "dvhop-packet.h"
+#include "multilateration.h"
+#include "trickle-state.h"
 
+#include <deque>
 #include <map>
 
 
@@ -30,12 +37,84 @@ struct Data{
 namespace ns3 {
   namespace dvhop{
 
+    // Estimator used to compute the position of a regular node
+    enum PositionSolver
+    {
+      TRILATERATION,  // First three beacons with a known hop size
+      LEAST_SQUARES   // Every beacon with a known hop size
+    };
+
+    // Scheduling of HELLO messages
+    enum HelloTimerMode
+    {
+      FIXED_TIMER,    // Every HelloInterval
+      TRICKLE_TIMER   // RFC 6206 Trickle, between TrickleImin and TrickleImax
+    };
+
+    // What a node did since it started, see RoutingProtocol::GetCounters
+    struct ProtocolCounters
+    {
+      ProtocolCounters ();
+      // Adds the counters of another node, keeping the latest first fix
+      ProtocolCounters& operator+= (const ProtocolCounters &other);
+
+      uint32_t hellosSent;          // HELLO packets handed to the socket
+      uint64_t helloBytesSent;      // Their size, IPv4 and UDP headers included
+      uint32_t packetsReceived;     // HELLO packets received
+      uint32_t hellosLost;          // HELLO packets missed according to the senders' counters
+      uint32_t duplicates;          // Received entries that did not change the table (stale, same or longer path)
+      uint32_t suppressedEntries;   // Entries left out of the HELLOs by split horizon
+      uint32_t tableInserts;        // Beacons added to the table
+      uint32_t tableImprovements;   // Known beacons given a new hop count or hop size
+      uint32_t solverRuns;          // Position solver invocations
+      uint32_t solverFailures;      // Of which without an estimate (fewer than 3 beacons, collinear)
+      Time     firstFix;            // Time of the first position estimate, negative if none yet
+    };
+
     class RoutingProtocol : public Ipv4RoutingProtocol{
     public:
       static const uint32_t DVHOP_PORT;
+      static const uint32_t IPV4_UDP_OVERHEAD;
       static TypeId GetTypeId (void);  // Develops a routing protocol ID
 
 
+      /**
+       * TracedCallback signature for HelloTx
+       * @param [in] packet The HELLO, FloodingBatchHeader included
+       * @param [in] destination The broadcast address
+       */
+      typedef void (* HelloTxTracedCallback)(Ptr<const Packet> packet, Ipv4Address destination);
+      /**
+       * TracedCallback signature for FloodingRx
+       * @param [in] header The received entry, hop count as advertised by the sender
+       * @param [in] sender The neighbour that sent it
+       */
+      typedef void (* FloodingRxTracedCallback)(const FloodingHeader &header, Ipv4Address sender);
+      /**
+       * TracedCallback signature for TableImproved
+       * @param [in] beacon The beacon address
+       * @param [in] oldHops The previous hop count, 0 for a new entry
+       * @param [in] newHops The new hop count
+       * @param [in] hopSize The hop size of the entry
+       */
+      typedef void (* TableImprovedTracedCallback)(Ipv4Address beacon, uint16_t oldHops, uint16_t newHops, double hopSize);
+      /**
+       * TracedCallback signature for PositionEstimate
+       * @param [in] oldPosition The previous estimate, (-1, -1) before the first fix
+       * @param [in] newPosition The new estimate
+       */
+      typedef void (* PositionEstimateTracedCallback)(Position oldPosition, Position newPosition);
+      /**
+       * TracedCallback signature for HopSizeChanged
+       * @param [in] oldHopSize The previous hop size, -1 before the first one
+       * @param [in] newHopSize The new hop size
+       */
+      typedef void (* HopSizeChangedTracedCallback)(double oldHopSize, double newHopSize);
+      /**
+       * TracedCallback signature for NodeDied
+       */
+      typedef void (* NodeDiedTracedCallback)(void);
+
       RoutingProtocol();
       virtual ~RoutingProtocol();    // Destructor, reallocates dynamically allocated memory from runtime
       virtual void DoDispose();      // Closes every socket in the node (one per interface)
@@ -63,14 +142,16 @@ namespace ns3 {
       void SetIsCritical(bool isCritical) { m_isCrit = isCritical; } 
 
       //Sets if node is a Beacon
-      void SetIsBeacon(bool isBeacon)    { m_isBeacon = isBeacon; }
+      void SetIsBeacon(bool isBeacon)    { m_isBeacon = isBeacon; m_anchorSumsValid = false; }
       //Sets beacon hop size
-      void SetHopSize(double hopSize)    { m_hopSize = hopSize; }
+      void SetHopSize(double hopSize)    { m_hopSize = hopSize; m_ownEntryDirty = true; }
       // Sets coordinate location of a node
-      void SetPosition(double x, double y) { m_xPosition = x; m_yPosition = y; }         
+      void SetPosition(double x, double y) { m_xPosition = x; m_yPosition = y; m_anchorSumsValid = false; }         
       // Gets node coordinates
       double GetXPosition()               { return m_xPosition;}                        
       double GetYPosition()               { return m_yPosition;}                       
+      // Gets node coordinates, recomputing them first if the estimate is stale
+      Position GetEstimatedPosition();
       // Predicates on if a node is a beacon
       bool  IsBeacon()                   { return m_isBeacon;}                            // Determines in the node is flagged as a beacon (knows its location)
       // Predicates on if a node is a beacon
@@ -78,6 +159,34 @@ namespace ns3 {
       // Returns the hop size of the beacon
       double GetHopSize()               { return m_hopSize;}
 
+      // Convergence state
+      // Whether the node knows its position (always true for beacons)
+      bool     HasPositionFix() const;
+      // Time of the last table change
+      Time     GetLastTableChange() const  { return m_lastTableChange; }
+      // Number of estimates that moved more than PositionEpsilon, the first fix included
+      uint32_t GetEstimateMoves() const    { return m_estimateMoves; }
+      // Time of the last table change or estimate move, updating the estimate first
+      Time     GetLastChange();
+
+      // Protocol overhead and activity of this node
+      const ProtocolCounters& GetCounters() const { return m_counters; }
+      // HELLO statistics: packets received, and packets missed according to the senders' counters
+      uint32_t GetHellosReceived() const   { return m_counters.packetsReceived; }
+      uint32_t GetHellosLost() const       { return m_counters.hellosLost; }
+      // Number of neighbours heard within NeighborTimeout, or the last two HELLO periods if longer
+      uint32_t GetNeighborDensity();
+      // Entries left out of the HELLOs by split horizon
+      uint32_t GetSuppressedEntries() const { return m_counters.suppressedEntries; }
+
+      // Warm start, before Simulator::Run: stores a beacon entry as the flooding
+      // would have converged to it, hops being this node's hop count to the beacon
+      void InjectBeacon(Ipv4Address beacon, uint16_t hops, double hopSize, double x, double y);
+      // Computes the hop size (beacons) or the position (regular nodes) from the injected entries
+      void FinishWarmStart();
+      // Address this node advertises as a beacon, that of its first DV-Hop interface
+      Ipv4Address GetBeaconAddress() const;
+
       //Sets the total time of the simulation
       void SetSimulationTime(double time) { m_totalTime = time; }
 
@@ -93,6 +202,8 @@ namespace ns3 {
       void        RecvDvhop(Ptr<Socket> socket);
       // Middle Functionn to allow for Critical Simulation
       void        Recieve(Ptr<Socket> socket);
+      // Forgets the neighbours not heard recently
+      void        PurgeNeighbors();
       // Finds socket based on Interface IP
       Ptr<Socket> FindSocketWithInterfaceAddress (Ipv4InterfaceAddress iface) const;
       //In case there exists a route to the destination, the packet is forwarded
@@ -103,15 +214,47 @@ namespace ns3 {
       Time   HelloInterval;
       Timer  m_htimer;
       void   SendHello();
+      // Adds an entry to the batch, sending the batch first if the entry does not fit
+      void   AppendEntry(FloodingBatchHeader &batch, const FloodingHeader &entry, uint16_t maxEntries,
+                         Ptr<Socket> socket, Ipv4Address destination);
+      // Queues one batch of HELLO entries, stamped with the interface's HELLO counter
+      void   SendBatch(Ptr<Socket> socket, const FloodingBatchHeader &batch, Ipv4Address destination);
+      // Schedules the single drain event of the round, jittered by queue length and neighbour density
+      void   ScheduleDrain(Ptr<Socket> socket);
+      // Sends the queued packets of an interface, back-to-back or one every m_txPacing
+      void   DrainTxQueue(Ptr<Socket> socket);
+      void   DropTxQueue(Ptr<Socket> socket);
       void   HelloTimerExpire();
+      // Critical mode: draws whether the node dies now, stopping its timers if so
+      bool   CheckNodeDeath();
+      void   LifeTimerExpire();
+
+      // Trickle timer (RFC 6206): m_htimer fires at the transmission point of
+      // the interval, m_trickleTimer at its end
+      void   StartTrickleInterval();
+      void   TrickleIntervalExpire();
+      // Shrinks the interval back to Imin after an inconsistency
+      void   TrickleReset();
+      // Whether an advertised entry matches the table once applied, see IsConsistentAdvertisement
+      bool   IsConsistent(const FloodingHeader &advertised) const;
 
       //Table to store the hopCount to each beacon
       DistanceTable  m_disTable;
-      void UpdateHopsTo (Ipv4Address beacon, uint16_t hops, double hopSize, double x, double y);
+      // Returns true when the hop size or position needs to be recomputed.
+      // Duplicates and entries older than the table's are dropped before any table work.
+      bool UpdateHopsTo (Ipv4Address beacon, uint16_t hops, double hopSize, double x, double y, uint16_t seqNo);
+      // Replaces the measurement of a beacon in the least squares solver
+      void UpdateSolverInput (const Position &pos, uint16_t oldHops, double oldHopSize, uint16_t newHops, double newHopSize);
+      // Adds the hop change of the anchor in a table slot to the beacon's running sums
+      void UpdateAnchorSums (uint32_t slot, uint16_t oldHops, uint16_t newHops);
       // Helps recalculate hop size of a beacon whenever it receives a braodcast
       void RecalculateHopSize();
       //Trilateration Function
       void Trilateration() ;
+      // Marks the estimate stale and recomputes it now or when m_solveTimer expires
+      void SchedulePositionUpdate();
+      // Recomputes the estimate if it is stale
+      void UpdatePosition();
       //Data output Function
       Data ComputeData() const;
 
@@ -136,13 +279,101 @@ namespace ns3 {
       // Raw socket per each IP interface, map socket -> iface address (IP + mask)
       std::map< Ptr<Socket>, Ipv4InterfaceAddress > m_socketAddresses;
 
-      uint32_t    m_seqNo;
+      // Sequence number of this beacon's entry, incremented every round
+      uint16_t    m_seqNo;
 
       // Total Time of the simulation to run
       double      m_totalTime;
       //Data on beacons used for trilateration
       Data    m_data;
 
+      // Triggered updates: send only changed entries between full refreshes
+      bool    m_triggeredUpdates;
+      Time    m_fullRefreshInterval;
+      Time    m_lastFullRefresh;
+      // The beacon's own entry (hop size) changed since the last HELLO
+      bool    m_ownEntryDirty;
+
+      // Position estimator and the running sums of every usable beacon
+      PositionSolver     m_solver;
+      LeastSquaresSolver m_lsSolver;
+
+      // Beacons only: sums of distances and hops to every other anchor, and the
+      // distance to the anchor in each table slot (anchors never move)
+      bool                m_anchorSumsValid;
+      double              m_anchorDistSum;
+      double              m_anchorHopSum;
+      std::vector<double> m_anchorDistances;
+
+      // Lazy position recomputation, at most once per m_positionUpdateInterval
+      Time    m_positionUpdateInterval;
+      Timer   m_solveTimer;
+      bool    m_positionDirty;
+
+      // HELLO encoding
+      WireFormat m_wireFormat;
+      uint8_t    m_coordinateBits;
+      double     m_coordinateResolution;
+
+      // Time after which an unconfirmed entry accepts a longer path
+      Time    m_staleEntryTimeout;
+
+      // Trickle parameters and state
+      HelloTimerMode m_helloTimerMode;
+      Time     m_trickleImin;
+      Time     m_trickleImax;
+      uint32_t m_trickleK;
+      TrickleState m_trickle;
+      Timer    m_trickleTimer;
+      // Critical mode death draws while Trickle drives m_htimer
+      Timer    m_lifeTimer;
+      // Set whenever the table or the advertised hop size changes
+      bool     m_tableChanged;
+      // Set while InjectBeacon stores an entry, which is not a protocol event
+      bool     m_injecting;
+
+      // Convergence tracking
+      Time     m_lastTableChange;
+      double   m_positionEpsilon;
+      uint32_t m_estimateMoves;
+      Time     m_lastEstimateMove;
+
+      // Simulation area, estimates are clamped to it
+      double   m_fieldWidth;
+      double   m_fieldHeight;
+
+      // HELLO packets waiting for the drain event of their interface
+      struct TxQueue
+      {
+        TxQueue () : helloCounter (0) {}
+        std::deque<Ptr<Packet> > packets;
+        Ipv4Address destination;
+        EventId     drainEvent;
+        uint16_t    helloCounter;
+      };
+      std::map<Ptr<Socket>, TxQueue> m_txQueues;
+      Time     m_txPacing;
+
+      // HELLO desynchronization
+      bool     m_randomStartPhase;
+      Time     m_maxJitter;
+      uint32_t m_jitterNeighborReference;
+
+      // What every one-hop neighbour advertised, for split horizon and the lost HELLO count
+      NeighborTable m_neighbors;
+      bool     m_splitHorizon;
+      Time     m_neighborTimeout;
+
+      ProtocolCounters m_counters;
+
+      // Protocol events, see the TracedCallback signatures above
+      TracedCallback<Ptr<const Packet>, Ipv4Address>            m_helloTxTrace;
+      TracedCallback<const FloodingHeader &, Ipv4Address>       m_floodingRxTrace;
+      TracedCallback<Ipv4Address, uint16_t, uint16_t, double>   m_tableImprovedTrace;
+      TracedCallback<Position, Position>                        m_positionEstimateTrace;
+      TracedCallback<double, double>                            m_hopSizeChangedTrace;
+      TracedCallback<>                                          m_nodeDiedTrace;
+
 
 
       //Used to simulate jitter
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "multilateration.h"
+#include <cmath>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    bool
+    Trilaterate (const double x[3], const double y[3], const double d[3], double &xOut, double &yOut)
+    {
+      double ex = x[1] - x[0];
+      double ey = y[1] - y[0];
+      double ez = x[1] * x[1] - x[0] * x[0] +
+                  y[1] * y[1] - y[0] * y[0] +
+                  d[0] * d[0] - d[1] * d[1];
+
+      double fx = x[2] - x[0];
+      double fy = y[2] - y[0];
+      double fz = x[2] * x[2] - x[0] * x[0] +
+                  y[2] * y[2] - y[0] * y[0] +
+                  d[0] * d[0] - d[2] * d[2];
+
+      double denominator = 2 * (ex * fy - ey * fx);
+      if (std::abs(denominator) < 1e-6) {
+        // The points are collinear or too close for trilateration
+        return false;
+      }
+
+      xOut = (ez * fy - ey * fz) / denominator;
+      yOut = (ex * fz - ez * fx) / denominator;
+      return true;
+    }
+
+
+    LeastSquaresSolver::LeastSquaresSolver ()
+    {
+      Clear ();
+    }
+
+    void
+    LeastSquaresSolver::Clear ()
+    {
+      m_n = 0;
+      m_sx = m_sy = m_sxx = m_syy = m_sxy = m_sb = m_sxb = m_syb = 0;
+    }
+
+    void
+    LeastSquaresSolver::Add (double x, double y, double distance)
+    {
+      m_n++;
+      Accumulate (x, y, distance, 1.0);
+    }
+
+    void
+    LeastSquaresSolver::Remove (double x, double y, double distance)
+    {
+      if (m_n == 0)
+        {
+          return;
+        }
+      m_n--;
+      if (m_n == 0)
+        {
+          Clear (); // Drop any rounding left in the sums
+          return;
+        }
+      Accumulate (x, y, distance, -1.0);
+    }
+
+    void
+    LeastSquaresSolver::Merge (const LeastSquaresSolver &other)
+    {
+      m_n += other.m_n;
+      m_sx += other.m_sx;
+      m_sy += other.m_sy;
+      m_sxx += other.m_sxx;
+      m_syy += other.m_syy;
+      m_sxy += other.m_sxy;
+      m_sb += other.m_sb;
+      m_sxb += other.m_sxb;
+      m_syb += other.m_syb;
+    }
+
+    void
+    LeastSquaresSolver::Accumulate (double x, double y, double distance, double sign)
+    {
+      double b = distance * distance - x * x - y * y;
+      m_sx += sign * x;
+      m_sy += sign * y;
+      m_sxx += sign * x * x;
+      m_syy += sign * y * y;
+      m_sxy += sign * x * y;
+      m_sb += sign * b;
+      m_sxb += sign * x * b;
+      m_syb += sign * y * b;
+    }
+
+    bool
+    LeastSquaresSolver::Solve (double &xOut, double &yOut) const
+    {
+      if (m_n < 3)
+        {
+          return false;
+        }
+
+      // Center the sums around the mean beacon
+      double n = m_n;
+      double cxx = m_sxx - m_sx * m_sx / n;
+      double cyy = m_syy - m_sy * m_sy / n;
+      double cxy = m_sxy - m_sx * m_sy / n;
+      double cxb = m_sxb - m_sx * m_sb / n;
+      double cyb = m_syb - m_sy * m_sb / n;
+
+      double det = cxx * cyy - cxy * cxy;
+      if (det <= 1e-9 * cxx * cyy || det < 1e-12)
+        {
+          // The beacons are collinear or too close
+          return false;
+        }
+
+      xOut = -0.5 * (cyy * cxb - cxy * cyb) / det;
+      yOut = -0.5 * (cxx * cyb - cxy * cxb) / det;
+      return true;
+    }
+
+  }
+}
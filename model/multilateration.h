@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef MULTILATERATION_H
+#define MULTILATERATION_H
+
+#include <stdint.h>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    /**
+     * @brief Trilaterate Solves a position from exactly three beacons
+     * @param x X coordinates of the beacons
+     * @param y Y coordinates of the beacons
+     * @param d Estimated distances to the beacons
+     * @param xOut Estimated X coordinate
+     * @param yOut Estimated Y coordinate
+     * @return False if the beacons are collinear or too close
+     */
+    bool Trilaterate (const double x[3], const double y[3], const double d[3], double &xOut, double &yOut);
+
+
+    /**
+     * @brief The LeastSquaresSolver class estimates a position from any
+     * number of beacons with linearized least squares.
+     *
+     * Each beacon i gives (x - xi)^2 + (y - yi)^2 = di^2, which is linear in
+     * (x, y, x^2 + y^2). Subtracting the mean of all equations removes the
+     * quadratic term and leaves the 2x2 normal equations
+     *   | Sxx Sxy | |x|        |Sxb|
+     *   | Sxy Syy | |y| = -1/2 |Syb|
+     * with S the centered sums over the beacons and b = di^2 - xi^2 - yi^2.
+     * Only the raw sums are stored, so adding or removing a beacon is O(1).
+     */
+    class LeastSquaresSolver
+    {
+    public:
+      LeastSquaresSolver();
+
+      /**
+       * @brief Add Adds a beacon measurement
+       * @param x X coordinate of the beacon
+       * @param y Y coordinate of the beacon
+       * @param distance Estimated distance to the beacon
+       */
+      void Add (double x, double y, double distance);
+
+      /**
+       * @brief Remove Removes a measurement previously added with the same values
+       */
+      void Remove (double x, double y, double distance);
+
+      /**
+       * @brief Merge Adds every measurement of another solver
+       */
+      void Merge (const LeastSquaresSolver &other);
+
+      void Clear ();
+
+      /**
+       * @brief GetN The number of measurements currently in the solver
+       */
+      uint32_t GetN () const { return m_n; }
+
+      /**
+       * @brief Solve Solves the normal equations
+       * @param xOut Estimated X coordinate
+       * @param yOut Estimated Y coordinate
+       * @return False with less than three beacons or when they are (nearly) collinear
+       */
+      bool Solve (double &xOut, double &yOut) const;
+
+    private:
+      void Accumulate (double x, double y, double distance, double sign);
+
+      uint32_t m_n;
+      // Raw sums of x, y, x^2, y^2, xy, b, xb and yb
+      double m_sx, m_sy, m_sxx, m_syy, m_sxy, m_sb, m_sxb, m_syb;
+    };
+
+  }
+}
+
+#endif // MULTILATERATION_H
@@ -0,0 +1,124 @@
+#include "neighbor-table.h"
+#include "distance-table.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+
+    NeighborTable::NeighborTable()		// Default Constructor
+    {
+    }
+
+    // Returns the number of HELLOs missed from the passed neighbour
+    uint16_t
+    NeighborTable::RecordHello (Ipv4Address neighbor, uint16_t counter)
+    {
+      std::pair<std::unordered_map<Ipv4Address, Neighbor, Ipv4AddressHash>::iterator, bool> ins =
+        m_neighbors.insert (std::make_pair (neighbor, Neighbor ()));
+      Neighbor &info = ins.first->second;
+      info.lastHeard = Simulator::Now ();
+      if (ins.second)
+        {
+          info.helloCounter = counter;
+          return 0;
+        }
+
+      // Counters only advance when the sender transmits, so a gap is a HELLO this node missed.
+      // Duplicates and reordered packets give a negative gap and are not counted.
+      int16_t gap = (int16_t)(uint16_t)(counter - info.helloCounter - 1);
+      if (gap < 0)
+        {
+          return 0;
+        }
+      info.helloCounter = counter;
+      return gap;
+    }
+
+    // Stores the entry the passed neighbour holds for a beacon
+    void
+    NeighborTable::RecordAdvertisement (Ipv4Address neighbor, Ipv4Address beacon, uint16_t hops, uint16_t seqNo, double hopSize)
+    {
+      std::unordered_map<Ipv4Address, Neighbor, Ipv4AddressHash>::iterator it = m_neighbors.find (neighbor);
+      if (it == m_neighbors.end ())
+        {
+          return;
+        }
+      std::pair<std::unordered_map<Ipv4Address, Advertisement, Ipv4AddressHash>::iterator, bool> ins =
+        it->second.beacons.insert (std::make_pair (beacon, Advertisement ()));
+      Advertisement &adv = ins.first->second;
+      if (!ins.second && IsNewerSequenceNumber (adv.seqNo, seqNo))
+        {
+          return; // Reordered, keep the newer entry
+        }
+      if (ins.second || adv.seqNo != seqNo)
+        {
+          adv.refreshedAt = Simulator::Now ();
+        }
+      adv.hops = hops;
+      adv.seqNo = seqNo;
+      adv.hopSize = hopSize;
+    }
+
+    // Returns true if any neighbour would update its table from this entry
+    bool
+    NeighborTable::IsNeeded (Ipv4Address beacon, uint16_t hops, uint16_t seqNo, double hopSize, Time staleTimeout) const
+    {
+      if (m_neighbors.empty ())
+        {
+          return true;
+        }
+
+      uint16_t offered = hops + 1;
+      for (std::unordered_map<Ipv4Address, Neighbor, Ipv4AddressHash>::const_iterator n = m_neighbors.begin ();
+           n != m_neighbors.end (); ++n)
+        {
+          if (n->first == beacon)
+            {
+              continue; // A beacon drops entries about itself, whatever their hop size
+            }
+          std::unordered_map<Ipv4Address, Advertisement, Ipv4AddressHash>::const_iterator it = n->second.beacons.find (beacon);
+          if (it == n->second.beacons.end ())
+            {
+              return true; // Unknown beacon for this neighbour
+            }
+          const Advertisement &adv = it->second;
+          if (IsNewerSequenceNumber (adv.seqNo, seqNo))
+            {
+              continue; // Would be dropped as stale, even with another hop size
+            }
+          if (hopSize > 0 && hopSize != adv.hopSize)
+            {
+              return true; // New hop size
+            }
+          if (seqNo == adv.seqNo ? offered < adv.hops
+                                 : offered <= adv.hops || Simulator::Now () - adv.refreshedAt >= staleTimeout)
+            {
+              return true; // Shorter path, or a fresher sequence number for the neighbour's path
+            }
+        }
+      return false;
+    }
+
+    // Removes the neighbours last heard before the horizon
+    void
+    NeighborTable::Purge (Time horizon)
+    {
+      std::unordered_map<Ipv4Address, Neighbor, Ipv4AddressHash>::iterator it = m_neighbors.begin ();
+      while (it != m_neighbors.end ())
+        {
+          if (it->second.lastHeard < horizon)
+            {
+              it = m_neighbors.erase (it);
+            }
+          else
+            {
+              ++it;
+            }
+        }
+    }
+
+  }
+}
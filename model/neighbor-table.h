@@ -0,0 +1,102 @@
+#ifndef NEIGHBORTABLE_H
+#define NEIGHBORTABLE_H
+
+#include <unordered_map>
+#include "ns3/ipv4.h"
+#include "ns3/nstime.h"
+
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    /**
+     * @brief The NeighborTable class stores what every one-hop neighbour
+     * advertised in its HELLOs: the last HELLO counter heard from it and, per
+     * beacon, the hop count, sequence number and hop size it holds.
+     *
+     * It lets a node skip the entries that no neighbour would accept (split
+     * horizon and suppression) and count the HELLOs it missed.
+     */
+    class NeighborTable
+    {
+    public:
+      NeighborTable();
+
+      /**
+       * @brief GetSize The number of neighbours stored in this table
+       * @return The size
+       */
+      size_t   GetSize() const  { return m_neighbors.size (); }
+
+      /**
+       * @brief RecordHello Records a HELLO, creating the neighbour if it is new
+       * @param neighbor The sender address
+       * @param counter The HELLO counter of the packet
+       * @return The number of HELLOs from this neighbour missed since the previous one
+       */
+      uint16_t RecordHello(Ipv4Address neighbor, uint16_t counter);
+
+      /**
+       * @brief RecordAdvertisement Records the entry a neighbour advertised for a beacon
+       * @param neighbor The sender address, RecordHello must have been called first
+       * @param beacon The beacon address
+       * @param hops The hop count advertised by the neighbour (its own hops to the beacon)
+       * @param seqNo The beacon sequence number of the entry
+       * @param hopSize The hop size of the entry
+       */
+      void     RecordAdvertisement(Ipv4Address neighbor, Ipv4Address beacon, uint16_t hops, uint16_t seqNo, double hopSize);
+
+      /**
+       * @brief IsNeeded Whether at least one neighbour would accept an advertisement,
+       * following the acceptance rules of RoutingProtocol::UpdateHopsTo
+       * @param beacon The beacon address
+       * @param hops The hops of this node to the beacon, the neighbours would store hops + 1
+       * @param seqNo The beacon sequence number this node holds
+       * @param hopSize The hop size this node holds
+       * @param staleTimeout Time without a newer sequence number after which a neighbour accepts a longer path
+       * @return True if a neighbour misses the beacon, holds a longer path, an older sequence
+       * number or another hop size, or if no neighbour is known. The beacon itself, as a
+       * neighbour, never needs its own entry
+       */
+      bool     IsNeeded(Ipv4Address beacon, uint16_t hops, uint16_t seqNo, double hopSize, Time staleTimeout) const;
+
+      /**
+       * @brief Purge Forgets the neighbours not heard since a given time
+       * @param horizon The oldest last-heard time kept
+       */
+      void     Purge(Time horizon);
+
+      /**
+       * @brief Clear Removes every neighbour
+       */
+      void     Clear()  { m_neighbors.clear (); }
+
+    private:
+      // The entry of one beacon as held by a neighbour
+      struct Advertisement
+      {
+        uint16_t hops;
+        uint16_t seqNo;
+        double   hopSize;
+        // Time the neighbour last advertised a newer sequence number
+        Time     refreshedAt;
+      };
+
+      struct Neighbor
+      {
+        uint16_t helloCounter;
+        Time     lastHeard;
+        std::unordered_map<Ipv4Address, Advertisement, Ipv4AddressHash> beacons;
+      };
+
+      // Sender address -> neighbour
+      std::unordered_map<Ipv4Address, Neighbor, Ipv4AddressHash> m_neighbors;
+    };
+
+  }
+}
+
+
+#endif // NEIGHBORTABLE_H
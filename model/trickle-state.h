@@ -0,0 +1,77 @@
+#ifndef TRICKLESTATE_H
+#define TRICKLESTATE_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include "ns3/nstime.h"
+
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    /**
+     * @brief IsConsistentAdvertisement Whether a neighbour's entry agrees with ours
+     * for Trickle (RFC 6206). Beacons issue a sequence number per advertised round,
+     * so a neighbour one round behind or ahead with the same path still agrees.
+     * @param seqNo, hops, hopSize The advertised entry
+     * @param ownSeqNo, ownHops, ownHopSize Our entry, hops 0 for our own beacon entry
+     * @param tolerance Largest hop size difference due to the wire encoding
+     * @return False if the sequence numbers are further apart, the hop sizes differ,
+     * or either side could improve the other's hop count
+     */
+    inline bool IsConsistentAdvertisement (uint16_t seqNo, uint16_t hops, double hopSize,
+                                           uint16_t ownSeqNo, uint16_t ownHops, double ownHopSize,
+                                           double tolerance)
+    {
+      uint16_t behind = ownSeqNo - seqNo;
+      uint16_t ahead = seqNo - ownSeqNo;
+      return (behind <= 1 || ahead <= 1)
+             && std::fabs (hopSize - ownHopSize) <= tolerance
+             && hops + 1 >= ownHops
+             && hops <= ownHops + 1;
+    }
+
+    /**
+     * @brief The TrickleState class holds the interval and the consistency
+     * counter of a Trickle timer (RFC 6206). The owner schedules the
+     * transmission point and the end of each interval.
+     */
+    class TrickleState
+    {
+    public:
+      TrickleState() : m_interval (Seconds (0)), m_counter (0) {}
+
+      Time     GetInterval() const  { return m_interval; }
+      uint32_t GetCounter() const   { return m_counter;  }
+
+      // Starts at the minimum interval
+      void Start(Time imin)            { m_interval = imin; m_counter = 0; }
+      // End of a consistent interval: the next one is twice as long, up to imax
+      void Double(Time imax)           { m_interval = std::min (m_interval + m_interval, imax); m_counter = 0; }
+      // Inconsistency: back to imin, false if already there (the interval goes on)
+      bool Reset(Time imin)
+      {
+        if (m_interval <= imin)
+          {
+            return false;
+          }
+        Start (imin);
+        return true;
+      }
+      // Consistent advertisements heard in the current interval
+      void AddConsistent(uint32_t n)   { m_counter += n; }
+      // Whether enough consistent advertisements were heard to skip this interval's transmission
+      bool IsSuppressed(uint32_t k) const  { return m_counter >= k; }
+
+    private:
+      Time     m_interval;
+      uint32_t m_counter;
+    };
+
+  }
+}
+
+#endif // TRICKLESTATE_H
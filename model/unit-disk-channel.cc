@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "unit-disk-channel.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3
+{
+  namespace dvhop
+  {
+    NS_LOG_COMPONENT_DEFINE ("DVHopUnitDiskChannel");
+
+    NS_OBJECT_ENSURE_REGISTERED (UnitDiskChannel);
+
+    TypeId
+    UnitDiskChannel::GetTypeId ()
+    {
+      static TypeId tid = TypeId ("ns3::dvhop::UnitDiskChannel")
+          .SetParent<SimpleChannel> ()
+          .AddConstructor<UnitDiskChannel> ()
+          .AddAttribute ("Range",
+                         "Maximum distance between two neighbours, in meters.",
+                         DoubleValue (25.0),
+                         MakeDoubleAccessor (&UnitDiskChannel::m_range),
+                         MakeDoubleChecker<double> (0))
+          .AddAttribute ("LossProbability",
+                         "Probability that a neighbour does not receive a packet.",
+                         DoubleValue (0.0),
+                         MakeDoubleAccessor (&UnitDiskChannel::m_lossProbability),
+                         MakeDoubleChecker<double> (0, 1))
+          .AddAttribute ("PropagationDelay",
+                         "Delay between the transmission and every reception.",
+                         TimeValue (Seconds (0)),
+                         MakeTimeAccessor (&UnitDiskChannel::m_delay),
+                         MakeTimeChecker ());
+      return tid;
+    }
+
+    UnitDiskChannel::UnitDiskChannel () :
+      m_range (25.0),
+      m_lossProbability (0.0),
+      m_delay (Seconds (0)),
+      m_graphValid (false)
+    {
+      m_lossRv = CreateObject<UniformRandomVariable> ();
+    }
+
+    UnitDiskChannel::~UnitDiskChannel ()
+    {
+    }
+
+    void
+    UnitDiskChannel::DoDispose ()
+    {
+      m_devices.clear ();
+      m_deviceIndex.clear ();
+      SimpleChannel::DoDispose ();
+    }
+
+    void
+    UnitDiskChannel::Add (Ptr<SimpleNetDevice> device)
+    {
+      m_deviceIndex[device] = m_devices.size ();
+      m_devices.push_back (device);
+      m_graphValid = false;
+    }
+
+    std::size_t
+    UnitDiskChannel::GetNDevices () const
+    {
+      return m_devices.size ();
+    }
+
+    Ptr<NetDevice>
+    UnitDiskChannel::GetDevice (std::size_t i) const
+    {
+      return m_devices[i];
+    }
+
+    int64_t
+    UnitDiskChannel::AssignStreams (int64_t stream)
+    {
+      m_lossRv->SetStream (stream);
+      return 1;
+    }
+
+    const UnitDiskGraph&
+    UnitDiskChannel::GetGraph ()
+    {
+      if (!m_graphValid)
+        BuildGraph ();
+      return m_graph;
+    }
+
+    void
+    UnitDiskChannel::BuildGraph ()
+    {
+      std::vector<double> x (m_devices.size ());
+      std::vector<double> y (m_devices.size ());
+      for (uint32_t i = 0; i < m_devices.size (); ++i)
+        {
+          Ptr<MobilityModel> mobility = m_devices[i]->GetNode ()->GetObject<MobilityModel> ();
+          NS_ASSERT_MSG (mobility, "UnitDiskChannel needs a MobilityModel on every node");
+          x[i] = mobility->GetPosition ().x;
+          y[i] = mobility->GetPosition ().y;
+        }
+      m_graph.Build (x, y, m_range);
+      m_graphValid = true;
+      NS_LOG_INFO (m_graph.GetNNodes () << " devices, " << m_graph.GetNLinks () << " links");
+    }
+
+    void
+    UnitDiskChannel::Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                           Ptr<SimpleNetDevice> sender)
+    {
+      NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
+      const UnitDiskGraph &graph = GetGraph ();
+      std::map<Ptr<SimpleNetDevice>, uint32_t>::const_iterator it = m_deviceIndex.find (sender);
+      NS_ASSERT_MSG (it != m_deviceIndex.end (), "Sender not attached to this channel");
+
+      // Devices filter on the destination address themselves, as with SimpleChannel
+      for (const uint32_t *n = graph.NeighborsBegin (it->second); n != graph.NeighborsEnd (it->second); ++n)
+        {
+          if (m_lossProbability > 0 && m_lossRv->GetValue () < m_lossProbability)
+            continue;
+          Ptr<SimpleNetDevice> device = m_devices[*n];
+          Simulator::ScheduleWithContext (device->GetNode ()->GetId (), m_delay,
+                                          &SimpleNetDevice::Receive, device, p->Copy (), protocol, to, from);
+        }
+    }
+
+  }
+}
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef UNIT_DISK_CHANNEL_H
+#define UNIT_DISK_CHANNEL_H
+
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+
+#include "unit-disk-graph.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    /**
+     * @brief The UnitDiskChannel class is a SimpleChannel that delivers a
+     * packet only to the devices within Range meters of the sender, each one
+     * independently dropped with LossProbability.
+     *
+     * It replaces the Wi-Fi PHY and MAC when the link model is a unit disk
+     * anyway (RangePropagationLossModel): there are no collisions and no
+     * transmission time, only the channel Delay. Neighbour sets are computed
+     * once from the MobilityModel of the nodes, on the first transmission
+     * after a device was added, so nodes must not move.
+     */
+    class UnitDiskChannel : public SimpleChannel
+    {
+    public:
+      static TypeId GetTypeId (void);
+
+      UnitDiskChannel ();
+      virtual ~UnitDiskChannel ();
+
+      virtual void Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                         Ptr<SimpleNetDevice> sender);
+      virtual void Add (Ptr<SimpleNetDevice> device);
+      virtual std::size_t GetNDevices (void) const;
+      virtual Ptr<NetDevice> GetDevice (std::size_t i) const;
+
+      /**
+       * @brief AssignStreams Fixes the stream of the loss random variable
+       * @return The number of streams used
+       */
+      int64_t AssignStreams (int64_t stream);
+
+      // Neighbour graph over the devices, in the order they were added
+      const UnitDiskGraph& GetGraph ();
+
+    protected:
+      virtual void DoDispose ();
+
+    private:
+      void BuildGraph ();
+
+      double   m_range;
+      double   m_lossProbability;
+      Time     m_delay;
+      Ptr<UniformRandomVariable> m_lossRv;
+
+      std::vector<Ptr<SimpleNetDevice> > m_devices;
+      std::map<Ptr<SimpleNetDevice>, uint32_t> m_deviceIndex;
+      UnitDiskGraph m_graph;
+      bool     m_graphValid;
+    };
+
+  }
+}
+
+#endif // UNIT_DISK_CHANNEL_H
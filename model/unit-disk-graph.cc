@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "unit-disk-graph.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    const uint16_t UnitDiskGraph::UNREACHABLE;
+
+    UnitDiskGraph::UnitDiskGraph ()
+    {
+    }
+
+    void
+    UnitDiskGraph::Build (const std::vector<double> &x, const std::vector<double> &y, double range)
+    {
+      uint32_t n = x.size ();
+      m_offsets.assign (n + 1, 0);
+      m_neighbors.clear ();
+      if (n == 0)
+        return;
+
+      double minX = *std::min_element (x.begin (), x.end ());
+      double maxX = *std::max_element (x.begin (), x.end ());
+      double minY = *std::min_element (y.begin (), y.end ());
+      double maxY = *std::max_element (y.begin (), y.end ());
+
+      // Cells at least one range wide, and no more cells than about 4 per node
+      double cell = std::max (range, std::sqrt ((maxX - minX) * (maxY - minY) / (4.0 * n)));
+      if (cell <= 0)
+        cell = 1;
+      uint32_t cols = (uint32_t)((maxX - minX) / cell) + 1;
+      uint32_t rows = (uint32_t)((maxY - minY) / cell) + 1;
+
+      // Counting sort of the nodes by cell
+      std::vector<uint32_t> cellOf (n);
+      std::vector<uint32_t> cellStart (cols * rows + 1, 0);
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint32_t cx = (uint32_t)((x[i] - minX) / cell);
+          uint32_t cy = (uint32_t)((y[i] - minY) / cell);
+          cellOf[i] = cy * cols + cx;
+          cellStart[cellOf[i] + 1]++;
+        }
+      for (uint32_t c = 0; c < cols * rows; ++c)
+        cellStart[c + 1] += cellStart[c];
+      std::vector<uint32_t> cellNodes (n);
+      std::vector<uint32_t> fill (cellStart.begin (), cellStart.end () - 1);
+      for (uint32_t i = 0; i < n; ++i)
+        cellNodes[fill[cellOf[i]]++] = i;
+
+      double range2 = range * range;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          int32_t cx = cellOf[i] % cols;
+          int32_t cy = cellOf[i] / cols;
+          for (int32_t ny = std::max (cy - 1, 0); ny <= std::min (cy + 1, (int32_t)rows - 1); ++ny)
+            {
+              for (int32_t nx = std::max (cx - 1, 0); nx <= std::min (cx + 1, (int32_t)cols - 1); ++nx)
+                {
+                  uint32_t c = ny * cols + nx;
+                  for (uint32_t k = cellStart[c]; k < cellStart[c + 1]; ++k)
+                    {
+                      uint32_t j = cellNodes[k];
+                      double dx = x[i] - x[j];
+                      double dy = y[i] - y[j];
+                      if (j != i && dx * dx + dy * dy <= range2)
+                        m_neighbors.push_back (j);
+                    }
+                }
+            }
+          m_offsets[i + 1] = m_neighbors.size ();
+        }
+    }
+
+    void
+    UnitDiskGraph::HopCounts (uint32_t source, std::vector<uint16_t> &hops) const
+    {
+      hops.assign (GetNNodes (), UNREACHABLE);
+      if (source >= GetNNodes ())
+        return;
+
+      // The vector is the FIFO: nodes are visited in the order they are discovered
+      std::vector<uint32_t> queue;
+      queue.reserve (GetNNodes ());
+      queue.push_back (source);
+      hops[source] = 0;
+      for (uint32_t head = 0; head < queue.size (); ++head)
+        {
+          uint32_t node = queue[head];
+          uint16_t next = hops[node] + 1;
+          if (next == UNREACHABLE)
+            break; // Hop counts saturate at 16 bits, like in FloodingHeader
+          for (const uint32_t *it = NeighborsBegin (node); it != NeighborsEnd (node); ++it)
+            {
+              if (hops[*it] == UNREACHABLE)
+                {
+                  hops[*it] = next;
+                  queue.push_back (*it);
+                }
+            }
+        }
+    }
+
+  }
+}
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef UNIT_DISK_GRAPH_H
+#define UNIT_DISK_GRAPH_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+  namespace dvhop
+  {
+
+    /**
+     * @brief The UnitDiskGraph class holds the links of a unit disk graph:
+     * two nodes are neighbours when they are at most Range meters apart.
+     *
+     * Build bins the nodes in a grid of cells at least Range wide, so each
+     * node is only compared with the nodes of the 3x3 surrounding cells, and
+     * stores the neighbour lists contiguously (compressed sparse rows).
+     */
+    class UnitDiskGraph
+    {
+    public:
+      static const uint16_t UNREACHABLE = 0xffff;
+
+      UnitDiskGraph();
+
+      /**
+       * @brief Build Computes the neighbours of every node
+       * @param x X coordinates of the nodes
+       * @param y Y coordinates of the nodes, same size as x
+       * @param range Maximum link distance in meters
+       */
+      void Build (const std::vector<double> &x, const std::vector<double> &y, double range);
+
+      uint32_t GetNNodes () const  { return m_offsets.empty () ? 0 : m_offsets.size () - 1; }
+      uint32_t GetNLinks () const  { return m_neighbors.size (); }
+      uint32_t GetDegree (uint32_t node) const { return m_offsets[node + 1] - m_offsets[node]; }
+
+      // Neighbours of a node, in [NeighborsBegin, NeighborsEnd)
+      const uint32_t* NeighborsBegin (uint32_t node) const { return m_neighbors.data () + m_offsets[node]; }
+      const uint32_t* NeighborsEnd (uint32_t node) const   { return m_neighbors.data () + m_offsets[node + 1]; }
+
+      /**
+       * @brief HopCounts Breadth first search from a node
+       * @param source The source node
+       * @param hops Filled with the hop count to every node, UNREACHABLE if disconnected
+       */
+      void HopCounts (uint32_t source, std::vector<uint16_t> &hops) const;
+
+    private:
+      // Neighbours of node i are m_neighbors[m_offsets[i]] to m_neighbors[m_offsets[i + 1] - 1]
+      std::vector<uint32_t> m_offsets;
+      std::vector<uint32_t> m_neighbors;
+    };
+
+  }
+}
+
+#endif // UNIT_DISK_GRAPH_H
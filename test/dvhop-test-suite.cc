@@ -2,10 +2,18 @@
 
 // Include a header file from your module to test.
 #include "ns3/dvhop.h"
+#include "ns3/dvhop-packet.h"
+#include "ns3/distance-table.h"
+#include "ns3/neighbor-table.h"
+#include "ns3/trickle-state.h"
+#include "ns3/multilateration.h"
+#include "ns3/unit-disk-graph.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <cmath>
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -46,6 +54,438 @@ DvhopTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Checks that a batch of flooding entries survives a serialize/deserialize round trip
+class FloodingBatchHeaderTestCase : public TestCase
+{
+public:
+  FloodingBatchHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FloodingBatchHeaderTestCase::FloodingBatchHeaderTestCase ()
+  : TestCase ("Flooding batch header serialization")
+{
+}
+
+void
+FloodingBatchHeaderTestCase::DoRun (void)
+{
+  dvhop::FloodingBatchHeader batch;
+  for (uint16_t i = 0; i < 5; ++i)
+    {
+      batch.AddEntry (dvhop::FloodingHeader (10.5 * i, 20.25 * i, i, i + 1, 3.5, Ipv4Address (0x0a000001 + i)));
+    }
+
+  batch.SetHelloCounter (0xfffe);
+
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (batch);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), batch.GetSerializedSize (), "Unexpected serialized size");
+
+  dvhop::FloodingBatchHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetHelloCounter (), 0xfffe, "Wrong HELLO counter");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNEntries (), 5, "Entries lost in the round trip");
+  for (uint16_t i = 0; i < received.GetNEntries (); ++i)
+    {
+      const dvhop::FloodingHeader &entry = received.GetEntry (i);
+      NS_TEST_ASSERT_MSG_EQ (entry.GetBeaconAddress (), Ipv4Address (0x0a000001 + i), "Wrong beacon address");
+      NS_TEST_ASSERT_MSG_EQ (entry.GetHopCount (), i + 1, "Wrong hop count");
+      NS_TEST_ASSERT_MSG_EQ_TOL (entry.GetXPosition (), 10.5 * i, 1e-9, "Wrong X position");
+      NS_TEST_ASSERT_MSG_EQ_TOL (entry.GetYPosition (), 20.25 * i, 1e-9, "Wrong Y position");
+      NS_TEST_ASSERT_MSG_EQ_TOL (entry.GetHopSize (), 3.5, 1e-9, "Wrong hop size");
+    }
+
+  // 2296 bytes of 802.11 MTU minus IP/UDP headers
+  NS_TEST_ASSERT_MSG_EQ (batch.GetMaxEntries (2296 - 28), 70, "Wrong batch capacity");
+}
+
+// Checks the quantization and address indexing of the compact batch format
+class CompactBatchHeaderTestCase : public TestCase
+{
+public:
+  CompactBatchHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CompactBatchHeaderTestCase::CompactBatchHeaderTestCase ()
+  : TestCase ("Compact flooding batch header serialization")
+{
+}
+
+void
+CompactBatchHeaderTestCase::DoRun (void)
+{
+  dvhop::FloodingBatchHeader batch;
+  batch.SetCompact (16, 0.01);
+  batch.AddEntry (dvhop::FloodingHeader (12.345, 99.999, 300, 1, -1.0, Ipv4Address (0x0a000102)));
+  batch.AddEntry (dvhop::FloodingHeader (-3.0, 1000.0, 7, 200, 17.126, Ipv4Address (0x0a00ffff)));
+  NS_TEST_ASSERT_MSG_EQ (batch.CanAdd (dvhop::FloodingHeader (0, 0, 0, 0, 0, Ipv4Address (0x0a010001))), false,
+                         "Beacon outside the base /16 accepted");
+
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (batch);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), batch.GetSerializedSize (), "Unexpected serialized size");
+  NS_TEST_ASSERT_MSG_LT (packet->GetSize (), 2 * 32u, "Compact batch is not smaller");
+
+  dvhop::FloodingBatchHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetFormat (), dvhop::COMPACT_FORMAT, "Wrong format");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNEntries (), 2, "Entries lost in the round trip");
+
+  const dvhop::FloodingHeader &first = received.GetEntry (0);
+  NS_TEST_ASSERT_MSG_EQ (first.GetBeaconAddress (), Ipv4Address (0x0a000102), "Wrong beacon address");
+  NS_TEST_ASSERT_MSG_EQ (first.GetSequenceNumber (), 300, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ_TOL (first.GetXPosition (), 12.35, 1e-9, "X not rounded to the resolution");
+  NS_TEST_ASSERT_MSG_EQ_TOL (first.GetYPosition (), 100.0, 1e-9, "Y not rounded to the resolution");
+  NS_TEST_ASSERT_MSG_EQ (first.GetHopSize () < 0, true, "Unknown hop size not preserved");
+
+  const dvhop::FloodingHeader &second = received.GetEntry (1);
+  NS_TEST_ASSERT_MSG_EQ (second.GetBeaconAddress (), Ipv4Address (0x0a00ffff), "Wrong beacon address");
+  NS_TEST_ASSERT_MSG_EQ (second.GetHopCount (), 200, "Wrong varint hop count");
+  NS_TEST_ASSERT_MSG_EQ_TOL (second.GetXPosition (), -3.0, 1e-9, "Negative X not preserved");
+  NS_TEST_ASSERT_MSG_EQ_TOL (second.GetYPosition (), 100.0 + 655.35, 1e-9, "Y not clamped to 16 bits above the origin");
+  NS_TEST_ASSERT_MSG_EQ_TOL (second.GetHopSize (), 17.13, 1e-9, "Wrong hop size");
+
+  // A version this node does not know is not parsed
+  Buffer buffer;
+  buffer.AddAtStart (batch.GetSerializedSize ());
+  batch.Serialize (buffer.Begin ());
+  buffer.Begin ().WriteU8 (7);
+  NS_TEST_ASSERT_MSG_EQ (received.Deserialize (buffer.Begin ()), 0, "Unknown version accepted");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNEntries (), 0, "Entries read from an unknown version");
+}
+
+// Checks lookups, slot stability and dirty tracking of the DistanceTable
+class DistanceTableTestCase : public TestCase
+{
+public:
+  DistanceTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DistanceTableTestCase::DistanceTableTestCase ()
+  : TestCase ("Distance table lookups and updates")
+{
+}
+
+void
+DistanceTableTestCase::DoRun (void)
+{
+  dvhop::DistanceTable table;
+  Ipv4Address a (0x0a000005), b (0x0a000002);
+
+  NS_TEST_ASSERT_MSG_EQ (table.AddBeacon (a, 3, -1.0, 10, 20), 0, "First beacon takes slot 0");
+  NS_TEST_ASSERT_MSG_EQ (table.AddBeacon (b, 1, 4.0, 30, 40), 1, "Second beacon takes slot 1");
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 2, "Wrong table size");
+  NS_TEST_ASSERT_MSG_EQ (table.Find (Ipv4Address (0x0a000009)) == 0, true, "Unknown beacon found");
+  NS_TEST_ASSERT_MSG_EQ (table.GetHopsTo (Ipv4Address (0x0a000009)), 0, "Unknown beacon has hops");
+
+  table.ClearDirty ();
+  NS_TEST_ASSERT_MSG_EQ (table.AddBeacon (a, 2, 5.0, 99, 99), 0, "Update moved the slot");
+  NS_TEST_ASSERT_MSG_EQ (table.IsDirty (a), true, "Updated entry is not dirty");
+  NS_TEST_ASSERT_MSG_EQ (table.IsDirty (b), false, "Untouched entry is dirty");
+  table.AddBeacon (b, 1, 4.0, 30, 40);
+  NS_TEST_ASSERT_MSG_EQ (table.IsDirty (b), false, "Unchanged entry became dirty");
+
+  const dvhop::BeaconInfo *info = table.Find (a);
+  NS_TEST_ASSERT_MSG_EQ (info->GetHops (), 2, "Wrong hops");
+  NS_TEST_ASSERT_MSG_EQ_TOL (info->GetHopSize (), 5.0, 1e-9, "Wrong hop size");
+  NS_TEST_ASSERT_MSG_EQ_TOL (info->GetPosition ().first, 10, 1e-9, "Beacon position must not change");
+
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsNewerSequenceNumber (5, 4), true, "5 is newer than 4");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsNewerSequenceNumber (4, 5), false, "4 is older than 5");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsNewerSequenceNumber (7, 7), false, "Equal is not newer");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsNewerSequenceNumber (2, 65530), true, "Wraparound not handled");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsNewerSequenceNumber (65530, 2), false, "Wraparound not handled");
+  table.ClearDirty ();
+  table.Refresh (a, 65535);
+  NS_TEST_ASSERT_MSG_EQ (table.Find (a)->GetSequenceNumber (), 65535, "Refresh lost the sequence number");
+  NS_TEST_ASSERT_MSG_EQ (table.IsDirty (a), true, "New sequence number not marked for the next update");
+  table.ClearDirty ();
+  table.Refresh (a, 65535);
+  NS_TEST_ASSERT_MSG_EQ (table.IsDirty (a), false, "Same sequence number marked dirty");
+
+  // The next round reaches this node over a 4 hop path before the 2 hop one
+  NS_TEST_ASSERT_MSG_EQ (table.AcceptsPath (a, 4, 0, Seconds (15)), false, "Longer path of a newer round replaced a confirmed one");
+  NS_TEST_ASSERT_MSG_EQ (table.AcceptsPath (a, 2, 0, Seconds (15)), true, "Same path of a newer round not accepted");
+  NS_TEST_ASSERT_MSG_EQ (table.AcceptsPath (a, 4, 0, Seconds (0)), true, "Unconfirmed entry kept its path");
+  NS_TEST_ASSERT_MSG_EQ (table.AcceptsPath (a, 3, 65535, Seconds (15)), false, "Longer path of the same round accepted");
+  NS_TEST_ASSERT_MSG_EQ (table.AcceptsPath (a, 1, 65534, Seconds (15)), false, "Older round accepted");
+
+  uint32_t visited = 0;
+  for (dvhop::DistanceTable::Iterator it = table.Begin (); it != table.End (); ++it, ++visited)
+    {
+      NS_TEST_ASSERT_MSG_EQ (table.GetIndexOf (it->GetAddress ()), (int32_t) visited, "Iteration is not in slot order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (visited, 2, "Iteration skipped entries");
+
+  // Selection by address, whatever the discovery order, skipping unknown hop sizes
+  dvhop::DistanceTable discovered;
+  discovered.AddBeacon (Ipv4Address (0x0a000009), 1, 4.0, 0, 0);
+  discovered.AddBeacon (Ipv4Address (0x0a000002), 1, -1.0, 0, 0);
+  discovered.AddBeacon (Ipv4Address (0x0a000007), 1, 4.0, 0, 0);
+  discovered.AddBeacon (Ipv4Address (0x0a000003), 1, 4.0, 0, 0);
+  discovered.AddBeacon (Ipv4Address (0x0a000005), 1, 4.0, 0, 0);
+  const dvhop::BeaconInfo *chosen[3];
+  NS_TEST_ASSERT_MSG_EQ (discovered.SelectLowestAddresses (chosen, 3), 3, "Wrong selection size");
+  NS_TEST_ASSERT_MSG_EQ (chosen[0]->GetAddress (), Ipv4Address (0x0a000003), "Wrong lowest address");
+  NS_TEST_ASSERT_MSG_EQ (chosen[1]->GetAddress (), Ipv4Address (0x0a000005), "Wrong second address");
+  NS_TEST_ASSERT_MSG_EQ (chosen[2]->GetAddress (), Ipv4Address (0x0a000007), "Wrong third address");
+}
+
+// Checks the lost HELLO count and the split horizon rules of the NeighborTable
+class NeighborTableTestCase : public TestCase
+{
+public:
+  NeighborTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NeighborTableTestCase::NeighborTableTestCase ()
+  : TestCase ("Neighbor table HELLO counters and suppression")
+{
+}
+
+void
+NeighborTableTestCase::DoRun (void)
+{
+  dvhop::NeighborTable table;
+  Ipv4Address n1 (0x0a000001), n2 (0x0a000002), beacon (0x0a000009);
+  Time stale = Seconds (3);
+
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 2, 10, 4.0, stale), true, "Without neighbours everything is sent");
+
+  NS_TEST_ASSERT_MSG_EQ (table.RecordHello (n1, 65534), 0, "First HELLO cannot be a loss");
+  NS_TEST_ASSERT_MSG_EQ (table.RecordHello (n1, 65535), 0, "Consecutive HELLOs are not a loss");
+  NS_TEST_ASSERT_MSG_EQ (table.RecordHello (n1, 2), 2, "Wraparound gap not counted");
+  NS_TEST_ASSERT_MSG_EQ (table.RecordHello (n1, 1), 0, "Reordered HELLO counted as a loss");
+  table.RecordHello (n2, 7);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 2, "Wrong neighbour count");
+
+  // n1 supplied the beacon at 1 hop, n2 does not know it yet
+  table.RecordAdvertisement (n1, beacon, 1, 10, 4.0);
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 2, 10, 4.0, stale), true, "n2 misses the beacon");
+
+  // Both hold the beacon at an equal or shorter hop count: split horizon and suppression
+  table.RecordAdvertisement (n2, beacon, 3, 10, 4.0);
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 2, 10, 4.0, stale), false, "Equal hop count re-advertised");
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 1, 10, 4.0, stale), true, "Shorter path suppressed");
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 2, 11, 4.0, stale), true, "Fresher sequence number suppressed");
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 2, 10, 5.0, stale), true, "New hop size suppressed");
+  NS_TEST_ASSERT_MSG_EQ (table.IsNeeded (beacon, 0, 9, 4.0, stale), false, "Older sequence number advertised");
+
+  table.Purge (Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 0, "Silent neighbours not purged");
+
+  // The beacon is a neighbour and advertises its own entry with a hop size this node
+  // does not hold yet, n1 already has a newer sequence number with another hop size
+  dvhop::NeighborTable beaconTable;
+  beaconTable.RecordHello (beacon, 1);
+  beaconTable.RecordAdvertisement (beacon, beacon, 0, 12, 4.5);
+  NS_TEST_ASSERT_MSG_EQ (beaconTable.IsNeeded (beacon, 1, 12, 4.0, stale), false, "Own entry offered to the beacon");
+  beaconTable.RecordHello (n1, 1);
+  beaconTable.RecordAdvertisement (n1, beacon, 1, 12, 4.5);
+  NS_TEST_ASSERT_MSG_EQ (beaconTable.IsNeeded (beacon, 1, 11, 4.0, stale), false, "Older hop size offered to a newer neighbour");
+  NS_TEST_ASSERT_MSG_EQ (beaconTable.IsNeeded (beacon, 1, 12, 4.0, stale), true, "Hop size of the same round suppressed");
+}
+
+// Checks the Trickle consistency rule and that a stable topology backs off to Imax
+class TrickleTestCase : public TestCase
+{
+public:
+  TrickleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TrickleTestCase::TrickleTestCase ()
+  : TestCase ("Trickle consistency and interval doubling")
+{
+}
+
+void
+TrickleTestCase::DoRun (void)
+{
+  // This node holds the beacon at 2 hops from round 10
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (10, 1, 4.0, 10, 2, 4.0, 0), true, "Same round upstream");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (9, 3, 4.0, 10, 2, 4.0, 0), true, "One round behind downstream");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (11, 3, 4.0, 10, 2, 4.0, 0), true, "One round ahead downstream");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (65535, 1, 4.0, 0, 2, 4.0, 0), true, "Wraparound not handled");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (8, 2, 4.0, 10, 2, 4.0, 0), false, "Two rounds behind");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (10, 4, 4.0, 10, 2, 4.0, 0), false, "Worse path than ours + 1");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (10, 0, 4.0, 10, 2, 4.0, 0), false, "Shorter path than ours - 1");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (10, 2, 5.0, 10, 2, 4.0, 0), false, "Different hop size");
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (10, 2, 4.004, 10, 2, 4.0, 0.01), true, "Compact rounding");
+  // A beacon hearing its previous round relayed back
+  NS_TEST_ASSERT_MSG_EQ (dvhop::IsConsistentAdvertisement (41, 1, 6.0, 42, 0, 6.0, 0), true, "Own entry relayed back");
+
+  // Stable topology: the beacon bumps its round every transmission and the
+  // neighbours relay it with one round of lag, from both sides of this node
+  Time imin = Seconds (1), imax = Seconds (64);
+  dvhop::TrickleState trickle;
+  trickle.Start (imin);
+  uint16_t ownSeqNo = 10;
+  for (uint32_t interval = 0; interval < 10; ++interval, ++ownSeqNo)
+    {
+      uint32_t consistent = 0;
+      consistent += dvhop::IsConsistentAdvertisement (ownSeqNo + 1, 1, 4.0, ownSeqNo, 2, 4.0, 0);
+      consistent += dvhop::IsConsistentAdvertisement (ownSeqNo - 1, 3, 4.0, ownSeqNo, 2, 4.0, 0);
+      NS_TEST_ASSERT_MSG_EQ (consistent, 2, "Relay lag taken as an inconsistency");
+      trickle.AddConsistent (consistent);
+      NS_TEST_ASSERT_MSG_EQ (trickle.IsSuppressed (2), true, "Transmission not suppressed");
+      trickle.Double (imax);
+      NS_TEST_ASSERT_MSG_EQ (trickle.GetCounter (), 0, "Counter not cleared for the next interval");
+    }
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetInterval (), imax, "Interval did not back off to Imax");
+
+  NS_TEST_ASSERT_MSG_EQ (trickle.Reset (imin), true, "Inconsistency did not reset the interval");
+  NS_TEST_ASSERT_MSG_EQ (trickle.GetInterval (), imin, "Reset interval is not Imin");
+  NS_TEST_ASSERT_MSG_EQ (trickle.Reset (imin), false, "Reset at Imin restarted the interval");
+}
+
+// Checks the three beacon and least squares position estimators
+class PositionSolverTestCase : public TestCase
+{
+public:
+  PositionSolverTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PositionSolverTestCase::PositionSolverTestCase ()
+  : TestCase ("Trilateration and least squares solvers")
+{
+}
+
+void
+PositionSolverTestCase::DoRun (void)
+{
+  const double tx = 37.0, ty = 61.5;
+  const double bx[5] = { 0, 100, 20, 80, 50 };
+  const double by[5] = { 0, 10, 90, 70, 40 };
+  double d[5];
+  for (int i = 0; i < 5; ++i)
+    {
+      d[i] = std::sqrt ((bx[i] - tx) * (bx[i] - tx) + (by[i] - ty) * (by[i] - ty));
+    }
+
+  double x, y;
+  NS_TEST_ASSERT_MSG_EQ (dvhop::Trilaterate (bx, by, d, x, y), true, "Trilateration failed");
+  NS_TEST_ASSERT_MSG_EQ_TOL (x, tx, 1e-6, "Wrong trilaterated X");
+  NS_TEST_ASSERT_MSG_EQ_TOL (y, ty, 1e-6, "Wrong trilaterated Y");
+
+  dvhop::LeastSquaresSolver solver;
+  for (int i = 0; i < 2; ++i)
+    {
+      solver.Add (bx[i], by[i], d[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (solver.Solve (x, y), false, "Solved with two beacons");
+
+  // A wrong measurement that is removed again must not bias the estimate
+  solver.Add (10, 10, 500);
+  for (int i = 2; i < 5; ++i)
+    {
+      solver.Add (bx[i], by[i], d[i]);
+    }
+  solver.Remove (10, 10, 500);
+  NS_TEST_ASSERT_MSG_EQ (solver.GetN (), 5, "Wrong number of measurements");
+  NS_TEST_ASSERT_MSG_EQ (solver.Solve (x, y), true, "Least squares failed");
+  NS_TEST_ASSERT_MSG_EQ_TOL (x, tx, 1e-6, "Wrong least squares X");
+  NS_TEST_ASSERT_MSG_EQ_TOL (y, ty, 1e-6, "Wrong least squares Y");
+
+  dvhop::LeastSquaresSolver collinear;
+  for (int i = 0; i < 4; ++i)
+    {
+      collinear.Add (10.0 * i, 10.0 * i, 5.0);
+    }
+  NS_TEST_ASSERT_MSG_EQ (collinear.Solve (x, y), false, "Solved with collinear beacons");
+}
+
+// Neighbours from the spatial grid must match the brute force ones
+class UnitDiskGraphTestCase : public TestCase
+{
+public:
+  UnitDiskGraphTestCase ();
+  virtual ~UnitDiskGraphTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+UnitDiskGraphTestCase::UnitDiskGraphTestCase ()
+  : TestCase ("Unit disk graph neighbours and hop counts")
+{
+}
+
+UnitDiskGraphTestCase::~UnitDiskGraphTestCase ()
+{
+}
+
+void
+UnitDiskGraphTestCase::DoRun (void)
+{
+  // A line of nodes 10 m apart plus an isolated node
+  std::vector<double> x, y;
+  for (int i = 0; i < 5; ++i)
+    {
+      x.push_back (10.0 * i);
+      y.push_back (0);
+    }
+  x.push_back (200);
+  y.push_back (200);
+
+  dvhop::UnitDiskGraph graph;
+  graph.Build (x, y, 10.0);
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNNodes (), 6, "Wrong number of nodes");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNLinks (), 8, "Links are only between consecutive nodes");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetDegree (0), 1, "End of the line has one neighbour");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetDegree (2), 2, "Middle of the line has two neighbours");
+
+  std::vector<uint16_t> hops;
+  graph.HopCounts (0, hops);
+  NS_TEST_ASSERT_MSG_EQ (hops[0], 0, "Source is at zero hops");
+  NS_TEST_ASSERT_MSG_EQ (hops[4], 4, "Wrong hop count along the line");
+  NS_TEST_ASSERT_MSG_EQ (hops[5], dvhop::UnitDiskGraph::UNREACHABLE, "Isolated node reached");
+
+  // Pseudo random placement against the O(n^2) definition
+  x.clear ();
+  y.clear ();
+  uint32_t seed = 12345;
+  for (int i = 0; i < 300; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      x.push_back ((seed >> 8) % 10000 / 100.0);
+      seed = seed * 1103515245 + 12345;
+      y.push_back ((seed >> 8) % 10000 / 100.0);
+    }
+  graph.Build (x, y, 12.5);
+  uint32_t links = 0;
+  for (uint32_t i = 0; i < x.size (); ++i)
+    {
+      uint32_t degree = 0;
+      for (uint32_t j = 0; j < x.size (); ++j)
+        {
+          double dx = x[i] - x[j], dy = y[i] - y[j];
+          if (i != j && dx * dx + dy * dy <= 12.5 * 12.5)
+            degree++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (graph.GetDegree (i), degree, "Grid missed or added neighbours");
+      links += degree;
+    }
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNLinks (), links, "Wrong number of links");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +501,13 @@ DvhopTestSuite::DvhopTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new DvhopTestCase1, TestCase::QUICK);
+  AddTestCase (new FloodingBatchHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new CompactBatchHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DistanceTableTestCase, TestCase::QUICK);
+  AddTestCase (new NeighborTableTestCase, TestCase::QUICK);
+  AddTestCase (new TrickleTestCase, TestCase::QUICK);
+  AddTestCase (new PositionSolverTestCase, TestCase::QUICK);
+  AddTestCase (new UnitDiskGraphTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite